@@ -1,204 +1,696 @@
-﻿/*
-* Copyright (c) 2019-2022 bestkakkoii llc.
-*
-* This software is provided 'as-is', without any express or implied
-* warranty.  In no event will the authors be held liable for any damages
-* arising from the use of this software.
-* Permission is granted to anyone to use this software for any purpose,
-* including commercial applications, and to alter it and redistribute it
-* freely, subject to the following restrictions:
-* 1. The origin of this software must not be misrepresented; you must not
-* claim that you wrote the original software. If you use this software
-* in a product, an acknowledgment in the product documentation would be
-* appreciated but is not required.
-* 2. Altered source versions must be plainly marked as such, and must not be
-* misrepresented as being the original software.
-* 3. This notice may not be removed or altered from any source distribution.
-*/
-#include "astar.h"
-#include "castar.h"
-
-BOOL APIENTRY DllMain(HMODULE hModule,
-	int  ul_reason_for_call,
-	LPVOID lpReserved
-)
-{
-	std::ignore = hModule;
-	std::ignore = lpReserved;
-	if (DLL_PROCESS_ATTACH == ul_reason_for_call) [[likely]]
-	{
-		CASTAR_INS;
-	}
-	else if (DLL_PROCESS_DETACH == ul_reason_for_call) [[unlikely]]
-	{
-		;
-	}
-	return TRUE;
-}
-
-ASTAR_API const int WINAPI startEx(
-
-	IN const wchar_t* mapid,
-	IN const int x1,
-	IN const int y1,
-	IN const int x2,
-	IN const int y2,
-	OUT std::vector<POINT>* path
-)
-{
-	CAStar& a = CASTAR_INS;
-	std::vector<MyPoint> v;
-
-	int ret = a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v);
-	if (ret)
-	{
-		ret = static_cast<int>(v.size());
-		*path = std::vector<POINT>();
-		for (const auto& it : v)
-		{
-			path->push_back(it.toPoint());
-		}
-	}
-
-	return ret;
-}
-
-ASTAR_API const int WINAPI start(
-
-	IN const wchar_t* mapid,
-	IN const int x1,
-	IN const int y1,
-	IN const int x2,
-	IN const int y2,
-	OUT wchar_t* path,
-	IN const unsigned char retmode
-)
-{
-	do
-	{
-		CAStar& a = CASTAR_INS;
-		std::vector<MyPoint> v;
-		const int ret = a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v);
-		if (!ret) break;
-
-		switch (retmode)
-		{
-		case 0: MAKETCARRAY(v, path); return ret;
-		case 1: MAKESTRARRAY(v, path); return ret;
-		default: break;
-		}
-	} while (0);
-	return 0;
-}
-
-ASTAR_API const int WINAPI createNewMap(IN const wchar_t* mapid, IN const int w, IN const int h)
-{
-	CAStar& a = CASTAR_INS;
-	return a._createNewMap(mapid, w, h);
-}
-
-ASTAR_API const int WINAPI freeMap(IN const wchar_t* mapid)
-{
-	CAStar& a = CASTAR_INS;
-	return a._freeMap(mapid);
-}
-
-ASTAR_API const int WINAPI addCollision(IN const wchar_t* mapid, IN const int x, IN const int y)
-{
-	CAStar& a = CASTAR_INS;
-	return a._addCollision(mapid, x, y);
-}
-
-ASTAR_API const int WINAPI removeCollision(IN const wchar_t* mapid, IN const int x, IN const int y)
-{
-	CAStar& a = CASTAR_INS;
-	return a._removeCollision(mapid, x, y);
-}
-
-ASTAR_API const int WINAPI printMap(IN const wchar_t* mapid, IN const wchar_t* fileName)
-{
-	CAStar& a = CASTAR_INS;
-	return a._printMap(mapid, fileName);
-}
-
-ASTAR_API const int WINAPI setWallColor(IN const int rgb)
-{
-	CAStar& a = CASTAR_INS;
-	const MyRGB c = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
-	a._setWallColor(c);
-	return 1;
-}
-
-ASTAR_API const int WINAPI setRoadColor(IN const int rgb)
-{
-	CAStar& a = CASTAR_INS;
-	const MyRGB c = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
-	a._setRoadColor(c);
-	return 1;
-}
-
-ASTAR_API const int WINAPI setPathColor(IN const int rgb)
-{
-	CAStar& a = CASTAR_INS;
-	const MyRGB c = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
-	a._setPathColor(c);
-	return 1;
-}
-
-ASTAR_API const int WINAPI enableAutoPrint(IN const bool b)
-{
-	CAStar& a = CASTAR_INS;
-	return a._enableAutoPrint(b);
-}
-
-ASTAR_API const int WINAPI enableCorner(IN const bool b)
-{
-	CAStar& a = CASTAR_INS;
-	return a._enableCorner(b);
-}
-
-ASTAR_API const int WINAPI setOutputDirectory(IN const wchar_t* dir)
-{
-	CAStar& a = CASTAR_INS;
-	return a._setOutputDirectory(dir);
-}
-
-ASTAR_API const int WINAPI mapSaveAs(IN const wchar_t* mapid, IN const wchar_t* fileName)
-{
-	CAStar& a = CASTAR_INS;
-	return a._mapSaveAs(mapid, fileName);
-}
-
-ASTAR_API const int WINAPI mapLoadFrom(IN const wchar_t* mapid, IN const wchar_t* fileName)
-{
-	CAStar& a = CASTAR_INS;
-	return a._mapLoadFrom(mapid, fileName);
-}
-
-ASTAR_API const int WINAPI isRoad(IN const wchar_t* mapid, IN const int x, IN const int y)
-{
-	CAStar& a = CASTAR_INS;
-	std::vector<MyPoint> v;
-	const int ret = a._getRoads(mapid, &v);
-	if (NULL == ret)
-		return -1;
-
-	return std::ranges::find(v, MyPoint{ x, y }) != v.end();
-}
-
-ASTAR_API const int WINAPI isCollision(IN const wchar_t* mapid, IN const int x, IN const int y)
-{
-	CAStar& a = CASTAR_INS;
-	std::vector<MyPoint> v;
-	const int ret = a._getCollisions(mapid, &v);
-	if (NULL == ret)
-		return -1;
-
-	return std::ranges::find(v, MyPoint{ x, y }) != v.end();
-}
-
-ASTAR_API const int WINAPI readBitmap(IN const wchar_t* mapid, IN const wchar_t* fileName)
-{
-	CAStar& a = CASTAR_INS;
-	return a._readBMPToBinary(mapid, fileName);
-}
\ No newline at end of file
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "astar.h"
+#include "castar.h"
+
+BOOL APIENTRY DllMain(HMODULE hModule,
+	int  ul_reason_for_call,
+	LPVOID lpReserved
+)
+{
+	std::ignore = hModule;
+	std::ignore = lpReserved;
+	if (DLL_PROCESS_ATTACH == ul_reason_for_call) [[likely]]
+	{
+		CASTAR_INS;
+	}
+	else if (DLL_PROCESS_DETACH == ul_reason_for_call) [[unlikely]]
+	{
+		;
+	}
+	return TRUE;
+}
+
+ASTAR_API const int WINAPI startEx(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path
+)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	int ret = a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v);
+	if (ret)
+	{
+		ret = static_cast<int>(v.size());
+		*path = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			path->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI startExWithEngine(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path,
+	IN const int engine
+)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	int ret = a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v, static_cast<ENGINETYPE>(engine));
+	if (ret)
+	{
+		ret = static_cast<int>(v.size());
+		*path = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			path->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+// the text of the path for a start() retmode, return the number of points in it, -1 if the retmode is unknown
+static const int pathText(const MyPoint& start, const std::vector<MyPoint>& v, const int retmode, std::wstring* text)
+{
+	std::vector<MyPoint> turns;
+	if (retmode >= 2)
+		my_turning_points(start, v, &turns);
+
+	switch (retmode)
+	{
+	case 0: *text = MAKETCARRAY(v); return static_cast<int>(v.size());
+	case 1: *text = MAKESTRARRAY(v); return static_cast<int>(v.size());
+	case 2: *text = MAKETCARRAY(turns); return static_cast<int>(turns.size());
+	case 3: *text = MAKESTRARRAY(turns); return static_cast<int>(turns.size());
+	default: return -1;
+	}
+}
+
+ASTAR_API const int WINAPI start(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT wchar_t* path,
+	IN const unsigned char retmode
+)
+{
+	do
+	{
+		CAStar& a = CASTAR_INS;
+		std::vector<MyPoint> v;
+		const int ret = a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v);
+		if (!ret) break;
+
+		std::wstring text;
+		if (pathText(MyPoint{ x1, y1 }, v, retmode, &text) < 0) break;
+
+		_snwprintf_s(path, text.size() + 1, _TRUNCATE, TEXT("%s"), text.c_str());
+		return ret;
+	} while (0);
+	return 0;
+}
+
+ASTAR_API const int WINAPI createNewMap(IN const wchar_t* mapid, IN const int w, IN const int h)
+{
+	CAStar& a = CASTAR_INS;
+	return a._createNewMap(mapid, w, h);
+}
+
+ASTAR_API const int WINAPI freeMap(IN const wchar_t* mapid)
+{
+	CAStar& a = CASTAR_INS;
+	return a._freeMap(mapid);
+}
+
+ASTAR_API const int WINAPI addCollision(IN const wchar_t* mapid, IN const int x, IN const int y)
+{
+	CAStar& a = CASTAR_INS;
+	return a._addCollision(mapid, x, y);
+}
+
+ASTAR_API const int WINAPI removeCollision(IN const wchar_t* mapid, IN const int x, IN const int y)
+{
+	CAStar& a = CASTAR_INS;
+	return a._removeCollision(mapid, x, y);
+}
+
+ASTAR_API const int WINAPI printMap(IN const wchar_t* mapid, IN const wchar_t* fileName)
+{
+	CAStar& a = CASTAR_INS;
+	return a._printMap(mapid, fileName);
+}
+
+ASTAR_API const int WINAPI setWallColor(IN const int rgb)
+{
+	CAStar& a = CASTAR_INS;
+	const MyRGB c = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
+	a._setWallColor(c);
+	return 1;
+}
+
+ASTAR_API const int WINAPI setRoadColor(IN const int rgb)
+{
+	CAStar& a = CASTAR_INS;
+	const MyRGB c = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
+	a._setRoadColor(c);
+	return 1;
+}
+
+ASTAR_API const int WINAPI setPathColor(IN const int rgb)
+{
+	CAStar& a = CASTAR_INS;
+	const MyRGB c = { static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb) };
+	a._setPathColor(c);
+	return 1;
+}
+
+ASTAR_API const int WINAPI enableAutoPrint(IN const bool b)
+{
+	CAStar& a = CASTAR_INS;
+	return a._enableAutoPrint(b);
+}
+
+ASTAR_API const int WINAPI enableCorner(IN const bool b)
+{
+	CAStar& a = CASTAR_INS;
+	return a._enableCorner(b);
+}
+
+ASTAR_API const int WINAPI setOutputDirectory(IN const wchar_t* dir)
+{
+	CAStar& a = CASTAR_INS;
+	return a._setOutputDirectory(dir);
+}
+
+ASTAR_API const int WINAPI mapSaveAs(IN const wchar_t* mapid, IN const wchar_t* fileName)
+{
+	CAStar& a = CASTAR_INS;
+	return a._mapSaveAs(mapid, fileName);
+}
+
+ASTAR_API const int WINAPI mapLoadFrom(IN const wchar_t* mapid, IN const wchar_t* fileName)
+{
+	CAStar& a = CASTAR_INS;
+	return a._mapLoadFrom(mapid, fileName);
+}
+
+ASTAR_API const int WINAPI isRoad(IN const wchar_t* mapid, IN const int x, IN const int y)
+{
+	CAStar& a = CASTAR_INS;
+	return a._isCell(mapid, x, y, TYPE_ROAD);
+}
+
+ASTAR_API const int WINAPI isCollision(IN const wchar_t* mapid, IN const int x, IN const int y)
+{
+	CAStar& a = CASTAR_INS;
+	return a._isCell(mapid, x, y, TYPE_COLLISION);
+}
+
+ASTAR_API const int WINAPI readBitmap(IN const wchar_t* mapid, IN const wchar_t* fileName)
+{
+	CAStar& a = CASTAR_INS;
+	return a._readBMPToBinary(mapid, fileName);
+}
+
+ASTAR_API const int WINAPI setEngine(IN const wchar_t* mapid, IN const int engine)
+{
+	CAStar& a = CASTAR_INS;
+	return a._setEngine((nullptr != mapid) ? mapid : TEXT(""), static_cast<ENGINETYPE>(engine));
+}
+
+ASTAR_API const int WINAPI enableJumpTable(IN const bool b)
+{
+	CAStar& a = CASTAR_INS;
+	return a._enableJumpTable(b);
+}
+
+ASTAR_API const int WINAPI enableMapChecksum(IN const bool b)
+{
+	CAStar& a = CASTAR_INS;
+	return a._enableMapChecksum(b);
+}
+
+ASTAR_API const int WINAPI buildJumpTable(IN const wchar_t* mapid)
+{
+	CAStar& a = CASTAR_INS;
+	return a._buildJumpTable(mapid);
+}
+
+ASTAR_API const int WINAPI buildHierarchy(IN const wchar_t* mapid, IN const int clusterSize)
+{
+	CAStar& a = CASTAR_INS;
+	return a._buildHierarchy(mapid, (clusterSize > 0) ? clusterSize : MyHpaGraph::kDefaultClusterSize);
+}
+
+ASTAR_API const int WINAPI startAbstract(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* waypoints
+)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	int ret = a._startAbstract(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v);
+	if (ret)
+	{
+		ret = static_cast<int>(v.size());
+		*waypoints = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			waypoints->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI refineSegment(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path
+)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	int ret = a._refineSegment(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v);
+	if (ret)
+	{
+		ret = static_cast<int>(v.size());
+		*path = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			path->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI isConnected(IN const wchar_t* mapid, IN const int x1, IN const int y1, IN const int x2, IN const int y2)
+{
+	CAStar& a = CASTAR_INS;
+	return a._isConnected(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 });
+}
+
+ASTAR_API const int WINAPI startBatch(
+
+	IN const PATHQUERY* queries,
+	IN const int count,
+	OUT POINT* points,
+	IN const int capacity,
+	OUT int* offsets,
+	OUT int* found
+)
+{
+	if ((nullptr == queries) || (count <= 0) || (nullptr == offsets))
+		return -1;
+
+	CAStar& a = CASTAR_INS;
+	std::vector<MyQuery> batch;
+	batch.reserve(count);
+	for (int i = 0; i < count; ++i)
+	{
+		const PATHQUERY& q = queries[i];
+		batch.push_back(MyQuery{ (nullptr != q.mapid) ? q.mapid : TEXT(""), MyPoint{ q.x1, q.y1 }, MyPoint{ q.x2, q.y2 } });
+	}
+
+	std::vector<MyPoint> v;
+	std::vector<int> offs;
+	std::vector<uint8_t> ok;
+	std::ignore = a._startBatch(batch, &v, &offs, &ok);
+
+	std::copy(offs.begin(), offs.end(), offsets);
+	if (nullptr != found)
+		std::copy(ok.begin(), ok.end(), found);
+
+	const int size = static_cast<int>(v.size());
+	if ((size > capacity) || ((size > 0) && (nullptr == points)))
+		return -1;
+
+	for (int i = 0; i < size; ++i)
+		points[i] = v[i].toPoint();
+
+	return size;
+}
+
+ASTAR_API const int WINAPI buildFlowField(IN const wchar_t* mapid, IN const int x, IN const int y)
+{
+	CAStar& a = CASTAR_INS;
+	return a._buildFlowField(mapid, MyPoint{ x, y });
+}
+
+ASTAR_API const int WINAPI startFlow(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path
+)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	int ret = a._startFlow(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v);
+	if (ret)
+	{
+		ret = static_cast<int>(v.size());
+		*path = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			path->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI flowNextStep(IN const wchar_t* mapid, IN const int gx, IN const int gy, IN const int x, IN const int y, OUT POINT* next)
+{
+	CAStar& a = CASTAR_INS;
+	MyPoint pos;
+	const int ret = a._flowNextStep(mapid, MyPoint{ gx, gy }, MyPoint{ x, y }, &pos);
+	if (ret && (nullptr != next))
+		*next = pos.toPoint();
+	return ret;
+}
+
+ASTAR_API const int WINAPI setPathCacheBudget(IN const unsigned long long bytes)
+{
+	CAStar& a = CASTAR_INS;
+	return a._setPathCacheBudget(static_cast<size_t>(bytes));
+}
+
+ASTAR_API const int WINAPI getPathCacheStats(OUT PATHCACHESTATS* stats)
+{
+	if (nullptr == stats)
+		return 0;
+
+	CAStar& a = CASTAR_INS;
+	const MyPathCache::Stats s = a._getPathCacheStats();
+	stats->hits = s.hits;
+	stats->misses = s.misses;
+	stats->evictions = s.evictions;
+	stats->invalidations = s.invalidations;
+	stats->bytes = s.bytes;
+	stats->entries = s.entries;
+	return 1;
+}
+
+ASTAR_API const int WINAPI createPlanner(IN const wchar_t* mapid, IN const int x, IN const int y)
+{
+	CAStar& a = CASTAR_INS;
+	return a._createPlanner(mapid, MyPoint{ x, y });
+}
+
+ASTAR_API const int WINAPI replan(IN const int handle, IN const int x, IN const int y, OUT std::vector<POINT>* path)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	int ret = a._replan(handle, MyPoint{ x, y }, &v);
+	if (ret > 0)
+	{
+		ret = static_cast<int>(v.size());
+		*path = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			path->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI destroyPlanner(IN const int handle)
+{
+	CAStar& a = CASTAR_INS;
+	return a._destroyPlanner(handle);
+}
+
+ASTAR_API const int WINAPI fillCollision(IN const wchar_t* mapid, IN const int x, IN const int y, IN const int w, IN const int h, IN const int collision)
+{
+	CAStar& a = CASTAR_INS;
+	return a._fillRect(mapid, MyRect{ x, y, w, h }, collision ? TYPE_COLLISION : TYPE_ROAD);
+}
+
+ASTAR_API const int WINAPI setCollisionSpans(IN const wchar_t* mapid, IN const COLLISIONSPAN* spans, IN const int count)
+{
+	CAStar& a = CASTAR_INS;
+	if ((nullptr == spans) || (count < 0))
+		return 0;
+
+	std::vector<MySpan> v(count);
+	for (int i = 0; i < count; ++i)
+	{
+		v[i] = MySpan{ spans[i].x, spans[i].y, spans[i].length, spans[i].collision ? TYPE_COLLISION : TYPE_ROAD };
+	}
+	return a._setSpans(mapid, v);
+}
+
+ASTAR_API const int WINAPI blitCollision(IN const wchar_t* mapid, IN const int x, IN const int y, IN const int w, IN const int h, IN const unsigned char* bits, IN const int pitch)
+{
+	CAStar& a = CASTAR_INS;
+	if ((nullptr == bits) || (w <= 0) || (h <= 0) || (pitch < ((w + 7) >> 3)))
+		return 0;
+
+	return a._blitMask(mapid, MyRect{ x, y, w, h }, bits, static_cast<size_t>(pitch));
+}
+
+// convert the points of a batch check and run it on one version
+static const int testCells(const wchar_t* mapid, const POINT* points, const int count, const OBJECTTYPE type, unsigned char* bits)
+{
+	CAStar& a = CASTAR_INS;
+	if ((nullptr == points) || (nullptr == bits) || (count <= 0))
+		return 0;
+
+	std::vector<MyPoint> v(count);
+	for (int i = 0; i < count; ++i)
+	{
+		v[i] = MyPoint{ static_cast<int>(points[i].x), static_cast<int>(points[i].y) };
+	}
+	return a._testCells(mapid, v, type, bits);
+}
+
+ASTAR_API const int WINAPI isRoadBatch(IN const wchar_t* mapid, IN const POINT* points, IN const int count, OUT unsigned char* bits)
+{
+	return testCells(mapid, points, count, TYPE_ROAD, bits);
+}
+
+ASTAR_API const int WINAPI isCollisionBatch(IN const wchar_t* mapid, IN const POINT* points, IN const int count, OUT unsigned char* bits)
+{
+	return testCells(mapid, points, count, TYPE_COLLISION, bits);
+}
+
+ASTAR_API const int WINAPI startPacked(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT unsigned char* buffer,
+	IN OUT int* size,
+	IN const int encoding
+)
+{
+	CAStar& a = CASTAR_INS;
+	if (nullptr == size)
+		return -1;
+
+	std::vector<MyPoint> v;
+	if (!a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v))
+	{
+		*size = 0;
+		return 0;
+	}
+
+	std::vector<MyPoint> turns;
+	if (encoding & PATH_TURNS)
+		my_turning_points(MyPoint{ x1, y1 }, v, &turns);
+
+	const std::vector<MyPoint>& points = (encoding & PATH_TURNS) ? turns : v;
+	std::vector<uint8_t> bytes;
+	if (!my_encode_path(points, encoding & ~PATH_TURNS, &bytes))
+		return -1;
+
+	const int capacity = *size;
+	*size = static_cast<int>(bytes.size());
+	if (nullptr == buffer)
+		return static_cast<int>(points.size());
+
+	if (capacity < *size)
+		return -1;
+
+	std::copy(bytes.begin(), bytes.end(), buffer);
+	return static_cast<int>(points.size());
+}
+
+ASTAR_API const int WINAPI startWithBudget(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path,
+	IN const int engine,
+	IN const int maxExpansions,
+	IN const int maxMicros
+)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	const MyBudget budget{ maxExpansions, maxMicros };
+	const int ret = a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v, static_cast<ENGINETYPE>(engine), budget);
+	*path = std::vector<POINT>();
+	for (const auto& it : v)
+	{
+		path->push_back(it.toPoint());
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI startBounded(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path,
+	IN const double epsilon,
+	IN const int mode,
+	OUT double* ratio
+)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	int ret = a._startBounded(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, MyBound{ epsilon, static_cast<BOUNDMODE>(mode) }, &v, ratio);
+	if (ret > 0)
+	{
+		ret = static_cast<int>(v.size());
+		*path = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			path->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI createSearch(IN const wchar_t* mapid, IN const int x1, IN const int y1, IN const int x2, IN const int y2)
+{
+	CAStar& a = CASTAR_INS;
+	return a._createSearch(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 });
+}
+
+ASTAR_API const int WINAPI stepSearch(IN const int handle, IN const int maxExpansions, IN const int maxMicros, OUT std::vector<POINT>* path)
+{
+	CAStar& a = CASTAR_INS;
+	std::vector<MyPoint> v;
+
+	const int ret = a._stepSearch(handle, MyBudget{ maxExpansions, maxMicros }, (nullptr != path) ? &v : nullptr);
+	if (nullptr != path)
+	{
+		*path = std::vector<POINT>();
+		for (const auto& it : v)
+		{
+			path->push_back(it.toPoint());
+		}
+	}
+
+	return ret;
+}
+
+ASTAR_API const int WINAPI destroySearch(IN const int handle)
+{
+	CAStar& a = CASTAR_INS;
+	return a._destroySearch(handle);
+}
+
+ASTAR_API const int WINAPI shutdownLibrary()
+{
+	CAStar& a = CASTAR_INS;
+	return a._shutdown();
+}
+
+ASTAR_API const int WINAPI startText(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT wchar_t* path,
+	IN OUT int* size,
+	IN const unsigned char retmode
+)
+{
+	CAStar& a = CASTAR_INS;
+	if (nullptr == size)
+		return -1;
+
+	std::vector<MyPoint> v;
+	if (!a._start(mapid, MyPoint{ x1, y1 }, MyPoint{ x2, y2 }, &v))
+	{
+		*size = 0;
+		return 0;
+	}
+
+	std::wstring text;
+	const int count = pathText(MyPoint{ x1, y1 }, v, retmode, &text);
+	if (count < 0)
+		return -1;
+
+	const int capacity = *size;
+	*size = static_cast<int>(text.size()) + 1;
+	if (nullptr == path)
+		return count;
+
+	if (capacity < *size)
+		return -1;
+
+	_snwprintf_s(path, static_cast<size_t>(capacity), _TRUNCATE, TEXT("%s"), text.c_str());
+	return count;
+}
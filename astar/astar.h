@@ -1,103 +1,351 @@
-﻿/*
-* Copyright (c) 2019-2022 bestkakkoii llc.
-*
-* This software is provided 'as-is', without any express or implied
-* warranty.  In no event will the authors be held liable for any damages
-* arising from the use of this software.
-* Permission is granted to anyone to use this software for any purpose,
-* including commercial applications, and to alter it and redistribute it
-* freely, subject to the following restrictions:
-* 1. The origin of this software must not be misrepresented; you must not
-* claim that you wrote the original software. If you use this software
-* in a product, an acknowledgment in the product documentation would be
-* appreciated but is not required.
-* 2. Altered source versions must be plainly marked as such, and must not be
-* misrepresented as being the original software.
-* 3. This notice may not be removed or altered from any source distribution.
-*/
-#pragma once
-#ifndef ASTAR_H
-#define ASTAR_H
-
-#ifdef ASTAR_EXPORTS
-#define ASTAR_API __declspec(dllexport)
-#else
-#define ASTAR_API __declspec(dllimport)
-#endif
-
-#include "myglobal.hpp"
-
-ASTAR_API const int WINAPI startEx(
-
-	IN const wchar_t* mapid,
-	IN const int x1,
-	IN const int y1,
-	IN const int x2,
-	IN const int y2,
-	OUT std::vector<POINT>* path
-);
-
-ASTAR_API const int WINAPI start(
-
-	IN const wchar_t* mapid,
-	IN const int x1,
-	IN const int y1,
-	IN const int x2,
-	IN const int y2,
-	OUT wchar_t* path,
-	IN const unsigned char retmode
-);
-
-ASTAR_API const int WINAPI createNewMap(
-
-	IN const wchar_t* mapid,
-	IN const int w,
-	IN const int h
-);
-
-ASTAR_API const int WINAPI freeMap(
-
-	IN const wchar_t* mapid
-);
-
-ASTAR_API const int WINAPI addCollision(
-	IN const wchar_t* mapid,
-	IN const int x,
-	IN const int y
-);
-
-ASTAR_API const int WINAPI removeCollision(
-	IN const wchar_t* mapid,
-	IN const int x,
-	IN const int y
-);
-
-ASTAR_API const int WINAPI printMap(
-
-	IN const wchar_t* mapid,
-	IN const wchar_t* fileName
-);
-
-ASTAR_API const int WINAPI setWallColor(IN const int rgb);
-
-ASTAR_API const int WINAPI setRoadColor(IN const int rgb);
-
-ASTAR_API const int WINAPI setPathColor(IN const int rgb);
-
-ASTAR_API const int WINAPI enableAutoPrint(IN const bool b);
-
-ASTAR_API const int WINAPI enableCorner(IN const bool b);
-
-ASTAR_API const int WINAPI setOutputDirectory(IN const wchar_t* dir);
-
-ASTAR_API const int WINAPI mapSaveAs(IN const wchar_t* mapid, IN const wchar_t* fileName);
-
-ASTAR_API const int WINAPI mapLoadFrom(IN const wchar_t* mapid, IN const wchar_t* fileName);
-
-ASTAR_API const int WINAPI isRoad(IN const wchar_t* mapid, IN const int x, IN const int y);
-
-ASTAR_API const int WINAPI isCollision(IN const wchar_t* mapid, IN const int x, IN const int y);
-
-ASTAR_API const int WINAPI readBitmap(IN const wchar_t* mapid, IN const wchar_t* fileName);
-
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#ifdef ASTAR_EXPORTS
+#define ASTAR_API __declspec(dllexport)
+#else
+#define ASTAR_API __declspec(dllimport)
+#endif
+
+#include "myglobal.hpp"
+
+ASTAR_API const int WINAPI startEx(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path
+);
+
+// same as startEx with the search engine picked for this query only (ENGINETYPE)
+ASTAR_API const int WINAPI startExWithEngine(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path,
+	IN const int engine
+);
+
+// retmode 0 writes the path as a TC array, 1 as "x,y|x,y" text, 2 and 3 the same with the turning points only
+// path must hold the whole text and its terminator, startText tells the size first
+ASTAR_API const int WINAPI start(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT wchar_t* path,
+	IN const unsigned char retmode
+);
+
+ASTAR_API const int WINAPI createNewMap(
+
+	IN const wchar_t* mapid,
+	IN const int w,
+	IN const int h
+);
+
+ASTAR_API const int WINAPI freeMap(
+
+	IN const wchar_t* mapid
+);
+
+ASTAR_API const int WINAPI addCollision(
+	IN const wchar_t* mapid,
+	IN const int x,
+	IN const int y
+);
+
+ASTAR_API const int WINAPI removeCollision(
+	IN const wchar_t* mapid,
+	IN const int x,
+	IN const int y
+);
+
+ASTAR_API const int WINAPI printMap(
+
+	IN const wchar_t* mapid,
+	IN const wchar_t* fileName
+);
+
+ASTAR_API const int WINAPI setWallColor(IN const int rgb);
+
+ASTAR_API const int WINAPI setRoadColor(IN const int rgb);
+
+ASTAR_API const int WINAPI setPathColor(IN const int rgb);
+
+ASTAR_API const int WINAPI enableAutoPrint(IN const bool b);
+
+ASTAR_API const int WINAPI enableCorner(IN const bool b);
+
+ASTAR_API const int WINAPI setOutputDirectory(IN const wchar_t* dir);
+
+// save the map in the mapped format: a versioned header and the bit-packed rows as they are kept in memory
+ASTAR_API const int WINAPI mapSaveAs(IN const wchar_t* mapid, IN const wchar_t* fileName);
+
+// load a map saved by mapSaveAs, the file is mapped and used as the map without copying and stays open while the map uses it
+// files of the old .dat format are still read and converted
+ASTAR_API const int WINAPI mapLoadFrom(IN const wchar_t* mapid, IN const wchar_t* fileName);
+
+// check the whole body of a mapped file against its checksum in mapLoadFrom, off by default: the load then reads only the header
+// and the last word of each row, and the pages of the body are read in as the map is used
+ASTAR_API const int WINAPI enableMapChecksum(IN const bool b);
+
+// return 1 if the cell is road (isRoad) or collision (isCollision), 0 if not or outside the map, -1 if the map does not exist
+ASTAR_API const int WINAPI isRoad(IN const wchar_t* mapid, IN const int x, IN const int y);
+
+ASTAR_API const int WINAPI isCollision(IN const wchar_t* mapid, IN const int x, IN const int y);
+
+ASTAR_API const int WINAPI readBitmap(IN const wchar_t* mapid, IN const wchar_t* fileName);
+
+// build the JPS+ table whenever a map is created or loaded
+ASTAR_API const int WINAPI enableJumpTable(IN const bool b);
+
+// build the JPS+ table of the map now, any later collision edit drops it again
+ASTAR_API const int WINAPI buildJumpTable(IN const wchar_t* mapid);
+
+// set the search engine of the map (ENGINETYPE), a null or empty mapid sets the default of all maps
+ASTAR_API const int WINAPI setEngine(IN const wchar_t* mapid, IN const int engine);
+
+// build the HPA* graph of the map for the current corner setting, clusterSize <= 0 picks the default
+// use it with setEngine/startExWithEngine (ENGINE_HPA) or with startAbstract and refineSegment
+ASTAR_API const int WINAPI buildHierarchy(IN const wchar_t* mapid, IN const int clusterSize);
+
+// search the HPA* graph only, the waypoints start with (x1, y1) and end with (x2, y2)
+// return the number of waypoints, 0 if no path or the map has no HPA* graph
+ASTAR_API const int WINAPI startAbstract(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* waypoints
+);
+
+// refine two consecutive waypoints from startAbstract to cells, (x1, y1) excluded
+// return the number of cells, 0 if failed
+ASTAR_API const int WINAPI refineSegment(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path
+);
+
+// check two points are passable and connected without running a search
+// while the labels of a loaded or heavily edited map are still being built the map is flooded from the first point instead
+// return 1 if connected, 0 if not, -1 if the map does not exist or a point is outside it
+ASTAR_API const int WINAPI isConnected(IN const wchar_t* mapid, IN const int x1, IN const int y1, IN const int x2, IN const int y2);
+
+// build the flow field of the goal (x, y) now instead of on the first startFlow or flowNextStep
+ASTAR_API const int WINAPI buildFlowField(IN const wchar_t* mapid, IN const int x, IN const int y);
+
+// read the path from (x1, y1) to the goal (x2, y2) out of the goal's flow field without searching
+// the field is built on first use and reused by every query with the same goal until the map changes
+ASTAR_API const int WINAPI startFlow(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path
+);
+
+// get the next cell from (x, y) towards the goal (gx, gy) out of the goal's flow field
+// return 0 at the goal or if the goal can not be reached
+ASTAR_API const int WINAPI flowNextStep(IN const wchar_t* mapid, IN const int gx, IN const int gy, IN const int x, IN const int y, OUT POINT* next);
+
+// set the byte budget of the path cache, 0 disables it (the default)
+// a cached path is reused by the same query (mapid, start, end, corner setting, engine) until an edit touches it
+ASTAR_API const int WINAPI setPathCacheBudget(IN const unsigned long long bytes);
+
+// counters of the path cache
+typedef struct tagPATHCACHESTATS
+{
+	unsigned long long hits;
+	unsigned long long misses;
+	unsigned long long evictions;       // dropped to stay inside the budget
+	unsigned long long invalidations;   // dropped by map edits
+	unsigned long long bytes;
+	unsigned long long entries;
+}PATHCACHESTATS;
+
+// get the counters of the path cache
+ASTAR_API const int WINAPI getPathCacheStats(OUT PATHCACHESTATS* stats);
+
+// create a D* Lite planner for the goal (x, y) on the map, it follows every collision edit of the map
+// freeing the map destroys its planners
+// return the handle, 0 if the map does not exist
+ASTAR_API const int WINAPI createPlanner(IN const wchar_t* mapid, IN const int x, IN const int y);
+
+// get the path from (x, y) to the goal of the planner, repairing the previous search after map edits
+// return the number of points, 0 if no path, -1 if the handle does not exist
+ASTAR_API const int WINAPI replan(IN const int handle, IN const int x, IN const int y, OUT std::vector<POINT>* path);
+
+// release the planner
+ASTAR_API const int WINAPI destroyPlanner(IN const int handle);
+
+// one query of startBatch
+typedef struct tagPATHQUERY
+{
+	const wchar_t* mapid;
+	int x1;
+	int y1;
+	int x2;
+	int y2;
+}PATHQUERY;
+
+// run independent queries in parallel, every map is pinned once for the whole batch
+// the path of query i (start point excluded) is points[offsets[i]] .. points[offsets[i + 1] - 1],
+// offsets needs count + 1 entries, found is optional and gets 1 for every query with a path, 0 otherwise
+// return the number of points written, -1 if capacity is too small (offsets[count] is the size needed)
+ASTAR_API const int WINAPI startBatch(
+
+	IN const PATHQUERY* queries,
+	IN const int count,
+	OUT POINT* points,
+	IN const int capacity,
+	OUT int* offsets,
+	OUT int* found
+);
+
+// set every cell of the rectangle to collision (collision != 0) or road as one edit, parts outside the map are ignored
+// return the number of cells changed, -1 if the map does not exist
+ASTAR_API const int WINAPI fillCollision(IN const wchar_t* mapid, IN const int x, IN const int y, IN const int w, IN const int h, IN const int collision);
+
+// one run of setCollisionSpans
+typedef struct tagCOLLISIONSPAN
+{
+	int x;
+	int y;
+	int length;                         // cells from (x, y) to the right
+	int collision;                      // 1 for collision, 0 for road
+}COLLISIONSPAN;
+
+// apply the runs as one edit, later runs win where they overlap
+// return the number of cells written, -1 if the map does not exist
+ASTAR_API const int WINAPI setCollisionSpans(IN const wchar_t* mapid, IN const COLLISIONSPAN* spans, IN const int count);
+
+// copy a bitmask onto the rectangle as one edit, parts outside the map are ignored
+// the mask has pitch bytes per row, cell i of a row is bit (i & 7) of byte (i >> 3), a set bit is a collision
+// return the number of cells changed, -1 if the map does not exist
+ASTAR_API const int WINAPI blitCollision(IN const wchar_t* mapid, IN const int x, IN const int y, IN const int w, IN const int h, IN const unsigned char* bits, IN const int pitch);
+
+// check many cells of one map version, bit (i & 7) of bits[i >> 3] is set when points[i] is road (isRoadBatch)
+// or collision (isCollisionBatch), points outside the map are neither, bits must hold (count + 7) / 8 bytes
+// return the number of set bits, -1 if the map does not exist
+ASTAR_API const int WINAPI isRoadBatch(IN const wchar_t* mapid, IN const POINT* points, IN const int count, OUT unsigned char* bits);
+
+ASTAR_API const int WINAPI isCollisionBatch(IN const wchar_t* mapid, IN const POINT* points, IN const int count, OUT unsigned char* bits);
+
+// find the path and write it in a binary encoding (PATHENCODING), add PATH_TURNS to keep only the turning points
+// *size holds the bytes of buffer and receives the bytes of the encoded path, a null buffer only asks for the size
+// (with the path cache enabled the second call with the sized buffer does not search again)
+// return the number of points encoded, 0 if no path was found, -1 if the buffer is too small or the encoding is unknown
+ASTAR_API const int WINAPI startPacked(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT unsigned char* buffer,
+	IN OUT int* size,
+	IN const int encoding
+);
+
+// same as startExWithEngine within limits, 0 is no limit: maxExpansions nodes taken from the open list, maxMicros microseconds
+// a limited query runs on A*, when a limit stops it the path leads to the node it reached closest to the end
+// return the SEARCHSTATUS: 1 if found, 2 or 3 if the expansion or time limit stopped it, 0 if no path
+ASTAR_API const int WINAPI startWithBudget(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path,
+	IN const int engine,
+	IN const int maxExpansions,
+	IN const int maxMicros
+);
+
+// find a path that costs at most (1 + epsilon) times the shortest one, expanding fewer nodes the larger epsilon is
+// mode is BOUND_WEIGHTED (weighted A*) or BOUND_FOCAL (focal search), ratio may be null
+// weighted A* is the faster one, focal search reopens nodes and can expand more than A* when epsilon is small
+// ratio receives the cost of the path over a lower bound of the shortest one, the real ratio is at most that
+// return the number of points, 0 if no path, -1 if epsilon or mode is invalid
+ASTAR_API const int WINAPI startBounded(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT std::vector<POINT>* path,
+	IN const double epsilon,
+	IN const int mode,
+	OUT double* ratio
+);
+
+// set up an A* query from (x1, y1) to (x2, y2) on the current version of the map, run a slice at a time by stepSearch
+// many searches can take turns on one thread, each keeps its nodes in a pooled context until it is over
+// return the handle, 0 if the map does not exist
+ASTAR_API const int WINAPI createSearch(IN const wchar_t* mapid, IN const int x1, IN const int y1, IN const int x2, IN const int y2);
+
+// run the search for at most maxExpansions expansions and maxMicros microseconds, 0 is no limit
+// path may be null, it receives the path once found and while in progress the path to the point closest to the end
+// return the SEARCHSTATUS: 1 if found, 0 if no path, 2 or 3 while in progress, -1 if the handle does not exist
+ASTAR_API const int WINAPI stepSearch(IN const int handle, IN const int maxExpansions, IN const int maxMicros, OUT std::vector<POINT>* path);
+
+// release the search, an unfinished one hands its context back
+ASTAR_API const int WINAPI destroySearch(IN const int handle);
+
+// destroy the search handles, stop the background threads and write the queued auto-print images, call it before FreeLibrary: the static destructors run under the loader lock
+// and can not wait for a thread there. the library still works afterwards, running everything on the calling thread
+ASTAR_API const int WINAPI shutdownLibrary();
+
+// find the path and write it as text in a start() retmode, bounded by the size of path
+// *size holds the characters of path and receives the characters of the text with its terminator, a null path only asks for the size
+// return the number of points written, 0 if no path was found, -1 if path is too small or the retmode is unknown
+ASTAR_API const int WINAPI startText(
+
+	IN const wchar_t* mapid,
+	IN const int x1,
+	IN const int y1,
+	IN const int x2,
+	IN const int y2,
+	OUT wchar_t* path,
+	IN OUT int* size,
+	IN const unsigned char retmode
+);
+
 #endif // !ASTAR_H
\ No newline at end of file
@@ -1,317 +1,913 @@
-﻿/*
-* Copyright (c) 2019-2022 bestkakkoii llc.
-*
-* This software is provided 'as-is', without any express or implied
-* warranty.  In no event will the authors be held liable for any damages
-* arising from the use of this software.
-* Permission is granted to anyone to use this software for any purpose,
-* including commercial applications, and to alter it and redistribute it
-* freely, subject to the following restrictions:
-* 1. The origin of this software must not be misrepresented; you must not
-* claim that you wrote the original software. If you use this software
-* in a product, an acknowledgment in the product documentation would be
-* appreciated but is not required.
-* 2. Altered source versions must be plainly marked as such, and must not be
-* misrepresented as being the original software.
-* 3. This notice may not be removed or altered from any source distribution.
-*/
-#include "castar.h"
-
-const int CAStar::_start(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v)
-{
-	auto draw = [&, this](const MyMap& map)->void
-	{
-		qimage img(map.width, map.height);
-
-		MyRGB color = {};
-
-		// draw map & path
-		for (const auto& obj : map.data)
-		{
-			color = (std::ranges::find(*v, obj.first) != v->end()) ? (pathColor) :
-				(((obj.second) == TYPE_ROAD) ? (roadColor) : (wallColor));
-
-			img.setPixel(obj.first, color);
-		}
-
-		if (this->outputdir.empty())
-		{
-			WCHAR szFilePath[MAX_PATH + 1];
-			GetModuleFileName(NULL, szFilePath, MAX_PATH);
-			(wcsrchr(szFilePath, TEXT('\\')))[1] = '\0';//replace '\\' to '\0'
-
-			const std::wstring f(std::format(TEXT(R"({}\{}.bmp)"), szFilePath, mapid));
-			std::ofstream(f) << img;
-		}
-		else
-		{
-			const std::wstring f(std::format(TEXT(R"({}\{}.bmp)"), this->outputdir, mapid));
-			std::ofstream(f) << img;
-		}
-	};
-
-	do
-	{
-		std::shared_lock<std::shared_mutex> lck(m_mutex);
-		v->clear();
-		const MyMap map = global_maps.at(mapid);
-		const Callback can_pass = [&map](const MyPoint& pos)->bool
-		{
-			if (map.data.contains(pos))
-				return map.data.at(pos) == TYPE_ROAD;
-			else
-				return false;
-		};
-
-		MyParams param(map.width, map.height, cornerenable, startPoint, endPoint, can_pass);
-		BlockAllocator allocator;
-		MyAStar astar(&allocator);
-
-		bool bret = astar.find(param, v);
-
-		if (!bret) break;
-		if (enableautoprint)
-			draw(map);
-		return 1;
-	} while (false);
-	return 0;
-}
-
-const bool CAStar::_createNewMap(const std::wstring& mapid, const int w, const int h)
-{
-	std::unique_lock<std::shared_mutex> lck(m_mutex);
-	bool bret = false;
-	do
-	{
-		if (((w) <= 0) || ((h) <= 0))
-			break;
-
-		global_maps.erase(mapid);
-		MyMap map = {};
-		map.width = w;
-		map.height = h;
-		int j = 0;
-		for (int i = 0; i < w; ++i)
-		{
-			for (j = 0; j < h; ++j)
-			{
-				map.data.insert(std::pair<MyPoint, OBJECTTYPE>{MyPoint{ i, j }, TYPE_ROAD
-				});
-			}
-		}
-
-		global_maps[mapid] = map;
-		bret = true;
-	} while (false);
-	return bret;
-}
-
-const bool CAStar::_freeMap(const std::wstring& mapid)
-{
-	std::unique_lock<std::shared_mutex> lck(m_mutex);
-	global_maps.erase(mapid);
-	return true;
-}
-
-const bool CAStar::_addCollision(const std::wstring& mapid, const int x, const int y)
-{
-	bool bret = false;
-	do
-	{
-		if (((x) < 0) ||
-			((y) < 0) ||
-			(NULL == (global_maps.at(mapid).width)) ||
-			(NULL == (global_maps.at(mapid).height)) ||
-			((x) >= (global_maps.at(mapid).width)) ||
-			((y) >= global_maps.at(mapid).height))
-			break;
-
-		global_maps.at(mapid).data.at(MyPoint{ x, y }) = TYPE_COLLISION;
-		bret = true;
-	} while (false);
-	return bret;
-}
-
-const bool CAStar::_removeCollision(const std::wstring& mapid, const int x, const int y)
-{
-	bool bret = false;
-	do
-	{
-		if (x < 0 ||
-			y < 0 ||
-			NULL == global_maps.at(mapid).width ||
-			NULL == global_maps.at(mapid).height ||
-			x >= global_maps.at(mapid).width ||
-			y >= global_maps.at(mapid).height)
-			break;
-
-		global_maps.at(mapid).data.at(MyPoint{ x, y }) = TYPE_ROAD;
-		bret = true;
-	} while (false);
-	return bret;
-}
-
-const int CAStar::_printMap(const std::wstring& mapid, const std::wstring& fileName)
-{
-	std::shared_lock<std::shared_mutex> lck(m_mutex);
-	int nret = 0;
-	do
-	{
-		const MyMap map = global_maps.at(mapid);
-		qimage img(map.width, map.height);
-
-		MyRGB color = {};
-		for (const auto& obj : map.data)
-		{
-			color = obj.second == TYPE_ROAD ? roadColor : wallColor;
-			img.setPixel(obj.first, color);
-		}
-
-		nret = 1;
-		std::ofstream(fileName) << img;
-	} while (false);
-	return nret;
-}
-
-void CAStar::_setWallColor(const MyRGB& rbg)
-{
-	wallColor = rbg;
-}
-
-void CAStar::_setRoadColor(const MyRGB& rbg)
-{
-	roadColor = rbg;
-}
-
-void CAStar::_setPathColor(const MyRGB& rbg)
-{
-	pathColor = rbg;
-}
-
-const int CAStar::_setOutputDirectory(const std::wstring& dir)
-{
-	this->outputdir = dir;
-	return !dir.empty();
-}
-
-const int CAStar::_mapSaveAs(const std::wstring& mapid, const std::wstring& fileName)
-{
-	const MyMap map = global_maps.at(mapid);
-
-	std::ofstream ofs(fileName, std::ios::binary);
-	if (!ofs.is_open())
-	{
-		return -1;
-	}
-
-	ofs.write(reinterpret_cast<const char*>(&map.width), sizeof(map.width));
-	ofs.write(reinterpret_cast<const char*>(&map.height), sizeof(map.height));
-
-	int y = 0;
-	for (int x = 0; x < map.width; ++x)
-	{
-		for (y = 0; y < map.height; ++y)
-		{
-			ofs.write(reinterpret_cast<const char*>(&map.data.at(MyPoint{ x, y })), sizeof(uint8_t));
-		}
-	}
-	ofs.close();
-
-	return 1;
-}
-
-const int CAStar::_mapLoadFrom(const std::wstring& mapid, const std::wstring& fileName)
-{
-	std::ifstream ifs(fileName, std::ios::binary);
-	if (!ifs.is_open())
-	{
-		return -1;
-	}
-
-	int width = 0;
-	int height = 0;
-
-	ifs.read(reinterpret_cast<char*>(&width), sizeof(width));
-	ifs.read(reinterpret_cast<char*>(&height), sizeof(height));
-
-	std::ignore = this->_createNewMap(mapid, width, height);
-
-	int y = 0;
-	for (int x = 0; x < width; ++x)
-	{
-		for (y = 0; y < height; ++y)
-		{
-			ifs.read(reinterpret_cast<char*>(&global_maps[mapid].data.at(MyPoint{ x, y })), sizeof(uint8_t));
-		}
-	}
-	ifs.close();
-
-	return 1;
-}
-
-const int CAStar::_getRoads(const std::wstring& mapid, std::vector<MyPoint>* v)
-{
-	std::shared_lock<std::shared_mutex> lck(m_mutex);
-	const MyMap map = global_maps.at(mapid);
-
-	for (const auto& obj : map.data)
-	{
-		if (TYPE_ROAD == obj.second)
-		{
-			v->push_back(obj.first);
-		}
-	}
-	return v->size();
-}
-
-const int CAStar::_getCollisions(const std::wstring& mapid, std::vector<MyPoint>* v)
-{
-	std::shared_lock<std::shared_mutex> lck(m_mutex);
-	const MyMap map = global_maps.at(mapid);
-
-	for (const auto& obj : map.data)
-	{
-		if (TYPE_COLLISION == obj.second)
-		{
-			v->push_back(obj.first);
-		}
-	}
-
-	return v->size();
-}
-
-const int CAStar::_readBMPToBinary(const std::wstring& mapid, const std::wstring& fileName)
-{
-	int width = 0, height = 0;
-	std::vector<std::vector<MyRGB>> vec;
-	MyDraw d{};
-	if (!d.bmpRead(vec, &width, &height, fileName))
-		return 0;
-
-	std::ignore = _createNewMap(mapid, width, height);
-
-	auto CHECKRANGE = [&height](int y)->bool
-	{
-		return (((height)-(y)) > 0) && (((height)-(y)) < height);
-	};
-
-	int y = 0;
-	for (int x = 0; x < width; ++x)
-	{
-		for (y = 0; y < height; ++y)
-		{
-			if ((vec.at(x).at(y)) == (wallColor))
-			{
-				if (CHECKRANGE(y))//upside-down
-					std::ignore = _addCollision(mapid, x, height - y);
-			}
-			else if ((vec.at(x).at(y)) == (roadColor))
-			{
-				if (CHECKRANGE(y))//upside-down
-					std::ignore = _removeCollision(mapid, x, height - y);
-			}
-		}
-	}
-
-	return 1;
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "castar.h"
+
+const int CAStar::_setEngine(const std::wstring& mapid, const ENGINETYPE engine)
+{
+	if ((engine < ENGINE_DEFAULT) || (engine > ENGINE_BIASTAR))
+		return 0;
+
+	std::unique_lock<std::shared_mutex> lck(m_mutex);
+	if (mapid.empty())
+	{
+		if (ENGINE_DEFAULT == engine)
+			return 0;
+
+		defaultengine = engine;
+	}
+	else if (ENGINE_DEFAULT == engine)
+	{
+		map_engines.erase(mapid);
+	}
+	else
+	{
+		map_engines[mapid] = engine;
+	}
+	return 1;
+}
+
+const int CAStar::_start(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v, const ENGINETYPE engine, const MyBudget& budget)
+{
+	do
+	{
+		v->clear();
+
+		// pin the current version, the search runs without holding any lock
+		const MyMapPtr map = _snapshot(mapid);
+		if (nullptr == map)
+			break;
+
+		const MyMap& grid = *map;
+		const SEARCHSTATUS status = _search(mapid, grid, startPoint, endPoint, v, _engineOf(mapid, engine), budget);
+		if (SEARCH_NOPATH == status)
+			break;
+
+		if (enableautoprint && (SEARCH_FOUND == status))
+			_autoPrint(mapid, map, *v);
+		return status;
+	} while (false);
+	return 0;
+}
+
+const int CAStar::_startBounded(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, const MyBound& bound, std::vector<MyPoint>* v, double* ratio)
+{
+	v->clear();
+	if (!(bound.epsilon >= 0.0) || ((BOUND_WEIGHTED != bound.mode) && (BOUND_FOCAL != bound.mode)))
+		return -1;
+
+	const MyMapPtr map = _snapshot(mapid);
+	if (nullptr == map)
+		return 0;
+
+	const MyMap& grid = *map;
+	if ((nullptr != grid.components) && grid.contains(startPoint.x(), startPoint.y())
+		&& grid.contains(endPoint.x(), endPoint.y()) && grid.components->separated(startPoint, endPoint))
+		return 0;
+
+	const MyParams param(grid.width, grid.height, cornerenable, startPoint, endPoint, nullptr);
+	MyContextLease context = MyContextPool::local().acquire(grid.width, grid.height);
+	if (!my_astar_find_bounded(context.get(), grid, param, bound, v, ratio))
+		return 0;
+
+	if (enableautoprint)
+		_autoPrint(mapid, map, *v);
+	return 1;
+}
+
+ENGINETYPE CAStar::_engineOf(const std::wstring& mapid, const ENGINETYPE engine) const
+{
+	if (ENGINE_DEFAULT != engine)
+		return engine;
+
+	std::shared_lock<std::shared_mutex> lck(m_mutex);
+	auto it = map_engines.find(mapid);
+	return (it != map_engines.end()) ? it->second : defaultengine;
+}
+
+const SEARCHSTATUS CAStar::_search(const std::wstring& mapid, const MyMap& grid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v, const ENGINETYPE engine, const MyBudget& budget)
+{
+	// points in different components are rejected before any search is set up
+	if ((nullptr != grid.components) && grid.contains(startPoint.x(), startPoint.y())
+		&& grid.contains(endPoint.x(), endPoint.y()) && grid.components->separated(startPoint, endPoint))
+		return SEARCH_NOPATH;
+
+	// only A* can stop on a limit, a limited query runs on it whatever engine is set
+	const ENGINETYPE used = budget.limited() ? ENGINE_ASTAR : engine;
+
+	// the key and the search see the same corner setting even if it changes meanwhile
+	const bool corner = cornerenable;
+	const bool cached = pathcache.enabled();
+	const MyPathCache::Key key{ mapid, startPoint, endPoint, corner, used };
+	if (cached && pathcache.get(key, grid.version, v))
+		return SEARCH_FOUND;
+
+	// the built-in grid runs the fully inlined search kernel, every thread has its own context
+	MyParams param(grid.width, grid.height, corner, startPoint, endPoint, nullptr);
+	MyContextLease context = MyContextPool::local().acquire(grid.width, grid.height);
+
+	SEARCHSTATUS status = SEARCH_NOPATH;
+	switch (used)
+	{
+	case ENGINE_JPS:
+		if (my_jps_find(context.get(), grid, param, v))
+			status = SEARCH_FOUND;
+		break;
+	case ENGINE_HPA:
+		if (my_hpa_find(context.get(), grid, param, v))
+			status = SEARCH_FOUND;
+		break;
+	case ENGINE_BIASTAR:
+	{
+		MyContextLease backward = MyContextPool::local().acquire(grid.width, grid.height);
+		if (my_astar_find_bidirectional(context.get(), backward.get(), grid, param, v))
+			status = SEARCH_FOUND;
+		break;
+	}
+	default:
+		status = my_astar_find(context.get(), grid, param, budget, v);
+		break;
+	}
+
+	// a partial path is not worth keeping
+	if ((SEARCH_FOUND == status) && cached)
+		pathcache.put(key, grid.version, *v);
+	return status;
+}
+
+const int CAStar::_startBatch(const std::vector<MyQuery>& queries, std::vector<MyPoint>* points, std::vector<int>* offsets, std::vector<uint8_t>* found)
+{
+	constexpr int kQueriesPerTask = 8;
+	const int count = static_cast<int>(queries.size());
+
+	// pin every map once, all queries on a map see the same version and no lock is taken per query
+	struct Pinned
+	{
+		MyMapPtr map;
+		ENGINETYPE engine;
+	};
+
+	std::unordered_map<std::wstring, Pinned> maps;
+	std::vector<const Pinned*> targets(count, nullptr);
+	for (int i = 0; i < count; ++i)
+	{
+		const std::wstring& mapid = queries[i].mapid;
+		auto it = maps.find(mapid);
+		if (it == maps.end())
+			it = maps.emplace(mapid, Pinned{ _snapshot(mapid), _engineOf(mapid, ENGINE_DEFAULT) }).first;
+		targets[i] = &it->second;
+	}
+
+	std::vector<std::vector<MyPoint>> paths(count);
+	found->assign(count, 0);
+	MyThreadPool::instance().parallel_for(count, kQueriesPerTask, [this, &queries, &targets, &paths, found](const int begin, const int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				const Pinned& target = *targets[i];
+				if ((nullptr != target.map) && (SEARCH_FOUND == _search(queries[i].mapid, *target.map, queries[i].start, queries[i].end, &paths[i], target.engine)))
+					(*found)[i] = 1;
+			}
+		});
+
+	offsets->assign(static_cast<size_t>(count) + 1, 0);
+	for (int i = 0; i < count; ++i)
+		(*offsets)[i + 1] = (*offsets)[i] + static_cast<int>(paths[i].size());
+
+	points->clear();
+	points->reserve(offsets->back());
+	for (const std::vector<MyPoint>& path : paths)
+		points->insert(points->end(), path.begin(), path.end());
+
+	return static_cast<int>(std::ranges::count(*found, static_cast<uint8_t>(1)));
+}
+
+const int CAStar::_shutdown()
+{
+	// the searches hand their contexts back here, while the pool of this thread is still alive
+	std::unordered_map<int, std::shared_ptr<MySearch>> open;
+	{
+		std::lock_guard<std::mutex> lck(m_searchMutex);
+		open.swap(searches);
+	}
+	open.clear();
+
+	MyPrintQueue::instance().stop();
+	MyThreadPool::instance().stop();
+	return 1;
+}
+
+const int CAStar::_isConnected(const std::wstring& mapid, const MyPoint& a, const MyPoint& b)
+{
+	const MyMapPtr map = _snapshot(mapid);
+	if ((nullptr == map) || !map->contains(a.x(), a.y()) || !map->contains(b.x(), b.y()))
+		return -1;
+
+	if (nullptr == map->components)
+		return MyComponents::reachable(*map, a, b) ? 1 : 0;
+
+	return map->components->connected(a, b) ? 1 : 0;
+}
+
+const int CAStar::_startAbstract(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v)
+{
+	v->clear();
+	const MyMapPtr map = _snapshot(mapid);
+	if ((nullptr == map) || (nullptr == map->hierarchy))
+		return 0;
+
+	const MyMap& grid = *map;
+	MyParams param(grid.width, grid.height, cornerenable, startPoint, endPoint, nullptr);
+	MyContextLease context = MyContextPool::local().acquire(grid.width, grid.height);
+	return grid.hierarchy->find(context.get(), grid, param, v) ? 1 : 0;
+}
+
+const int CAStar::_refineSegment(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v)
+{
+	v->clear();
+	const MyMapPtr map = _snapshot(mapid);
+	if ((nullptr == map) || (nullptr == map->hierarchy))
+		return 0;
+
+	const MyMap& grid = *map;
+	MyContextLease context = MyContextPool::local().acquire(grid.width, grid.height);
+	return grid.hierarchy->refine(context.get(), grid, startPoint, endPoint, v) ? 1 : 0;
+}
+
+const int CAStar::_buildFlowField(const std::wstring& mapid, const MyPoint& goal)
+{
+	const MyMapPtr map = _snapshot(mapid);
+	if (nullptr == map)
+		return 0;
+
+	return (nullptr != flowfields.get(mapid, *map, goal, cornerenable)) ? 1 : 0;
+}
+
+const int CAStar::_startFlow(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& goal, std::vector<MyPoint>* v)
+{
+	v->clear();
+	const MyMapPtr map = _snapshot(mapid);
+	if (nullptr == map)
+		return 0;
+
+	const std::shared_ptr<const MyFlowField> field = flowfields.get(mapid, *map, goal, cornerenable);
+	if (nullptr == field)
+		return 0;
+
+	return field->path(startPoint, v) ? 1 : 0;
+}
+
+const int CAStar::_flowNextStep(const std::wstring& mapid, const MyPoint& goal, const MyPoint& pos, MyPoint* next)
+{
+	const MyMapPtr map = _snapshot(mapid);
+	if (nullptr == map)
+		return 0;
+
+	const std::shared_ptr<const MyFlowField> field = flowfields.get(mapid, *map, goal, cornerenable);
+	if (nullptr == field)
+		return 0;
+
+	return field->next(pos, next) ? 1 : 0;
+}
+
+const int CAStar::_createPlanner(const std::wstring& mapid, const MyPoint& goal)
+{
+	if (nullptr == _snapshot(mapid))
+		return 0;
+
+	std::lock_guard<std::mutex> lck(m_plannerMutex);
+	const int handle = ++m_lastPlanner;
+	planners.emplace(handle, Planner{ mapid, std::make_shared<MyDStarLite>(goal, cornerenable) });
+	return handle;
+}
+
+const int CAStar::_replan(const int handle, const MyPoint& startPoint, std::vector<MyPoint>* v)
+{
+	v->clear();
+	Planner planner;
+	{
+		std::lock_guard<std::mutex> lck(m_plannerMutex);
+		auto it = planners.find(handle);
+		if (it == planners.end())
+			return -1;
+		planner = it->second;
+	}
+
+	const MyMapPtr map = _snapshot(planner.mapid);
+	if (nullptr == map)
+		return 0;
+
+	return planner.planner->replan(map, startPoint, v) ? 1 : 0;
+}
+
+const int CAStar::_destroyPlanner(const int handle)
+{
+	std::lock_guard<std::mutex> lck(m_plannerMutex);
+	return (planners.erase(handle) > 0) ? 1 : 0;
+}
+
+const int CAStar::_createSearch(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint)
+{
+	const MyMapPtr map = _snapshot(mapid);
+	if (nullptr == map)
+		return 0;
+
+	const MyParams param(map->width, map->height, cornerenable, startPoint, endPoint, nullptr);
+	auto search = std::make_shared<MySearch>(map, param);
+
+	std::lock_guard<std::mutex> lck(m_searchMutex);
+	const int handle = ++m_lastSearch;
+	searches.emplace(handle, std::move(search));
+	return handle;
+}
+
+const int CAStar::_stepSearch(const int handle, const MyBudget& budget, std::vector<MyPoint>* v)
+{
+	std::shared_ptr<MySearch> search;
+	{
+		std::lock_guard<std::mutex> lck(m_searchMutex);
+		auto it = searches.find(handle);
+		if (it == searches.end())
+			return -1;
+		search = it->second;
+	}
+
+	const SEARCHSTATUS status = search->step(budget);
+	if (nullptr != v)
+		search->path(v);
+	return status;
+}
+
+const int CAStar::_destroySearch(const int handle)
+{
+	std::shared_ptr<MySearch> search;
+	{
+		std::lock_guard<std::mutex> lck(m_searchMutex);
+		auto it = searches.find(handle);
+		if (it == searches.end())
+			return 0;
+		// an unfinished search hands its context back after the lock is released
+		search = std::move(it->second);
+		searches.erase(it);
+	}
+	return 1;
+}
+
+void CAStar::_notifyPlanners(const std::wstring& mapid, const MyPoint* pos, const uint64_t version)
+{
+	std::lock_guard<std::mutex> lck(m_plannerMutex);
+	for (auto& it : planners)
+	{
+		if (it.second.mapid != mapid)
+			continue;
+
+		if (nullptr != pos)
+			it.second.planner->changed(*pos, version);
+		else
+			it.second.planner->reset(version);
+	}
+}
+
+MyMapPtr CAStar::_snapshot(const std::wstring& mapid) const
+{
+	return global_maps.snapshot(mapid);
+}
+
+void CAStar::_publishNew(const std::wstring& mapid, MyMapEditor& editor, const bool deferLabels)
+{
+	if (!deferLabels)
+	{
+		editor.attach(MyComponents::build(editor.map()));
+	}
+	if (enablejumptable)
+	{
+		editor.attach(MyJumpTable::build(editor.map()));
+	}
+
+	{
+		MyMapRegistry::Writer writer = global_maps.write(mapid, true);
+		const uint64_t version = ++m_version;
+		writer.publish(editor.publish(version));
+
+		// everything derived from the replaced map is dropped
+		flowfields.erase(mapid);
+		pathcache.erase(mapid);
+		_notifyPlanners(mapid, nullptr, version);
+	}
+
+	// the task takes the write lock of the map itself
+	if (deferLabels)
+	{
+		_buildComponentsLater(mapid);
+	}
+}
+
+void CAStar::_buildComponentsLater(const std::wstring& mapid)
+{
+	MyThreadPool::instance().submit([this, mapid]()
+		{
+			// an edit made meanwhile publishes a version without labels, so the labels are built again for it
+			for (;;)
+			{
+				const MyMapPtr map = _snapshot(mapid);
+				if ((nullptr == map) || (nullptr != map->components))
+					return;
+
+				std::shared_ptr<const MyComponents> labels = MyComponents::build(*map);
+
+				MyMapRegistry::Writer writer = global_maps.write(mapid, false);
+				const MyMapPtr current = writer.current();
+				if ((nullptr == current) || (nullptr != current->components))
+					return;
+
+				if (current->version != map->version)
+					continue;
+
+				// same cells, same version, only the labels are added
+				std::shared_ptr<MyMap> copy = std::make_shared<MyMap>(*current);
+				copy->components = std::move(labels);
+				writer.publish(std::move(copy));
+				return;
+			}
+		});
+}
+
+const int CAStar::_buildJumpTable(const std::wstring& mapid)
+{
+	MyMapRegistry::Writer writer = global_maps.write(mapid, false);
+	const MyMapPtr map = writer.current();
+	if (nullptr == map)
+		return 0;
+
+	if (nullptr != map->jump_table)
+		return 1;
+
+	std::shared_ptr<const MyJumpTable> table = MyJumpTable::build(*map);
+	if (nullptr == table)
+		return 0;
+
+	// same cells, same version, only the table is added
+	std::shared_ptr<MyMap> copy = std::make_shared<MyMap>(*map);
+	copy->jump_table = std::move(table);
+	writer.publish(std::move(copy));
+	return 1;
+}
+
+const int CAStar::_buildHierarchy(const std::wstring& mapid, const int clusterSize)
+{
+	MyMapRegistry::Writer writer = global_maps.write(mapid, false);
+	const MyMapPtr map = writer.current();
+	if (nullptr == map)
+		return 0;
+
+	std::shared_ptr<const MyHpaGraph> graph = MyHpaGraph::build(*map, clusterSize, cornerenable);
+	if (nullptr == graph)
+		return 0;
+
+	// same cells, same version, only the graph is replaced
+	std::shared_ptr<MyMap> copy = std::make_shared<MyMap>(*map);
+	copy->hierarchy = std::move(graph);
+	writer.publish(std::move(copy));
+	return 1;
+}
+
+const bool CAStar::_setCell(const std::wstring& mapid, const int x, const int y, const OBJECTTYPE type)
+{
+	MyMapRegistry::Writer writer = global_maps.write(mapid, false);
+	bool bret = false;
+	do
+	{
+		const MyMapPtr map = writer.current();
+		if ((nullptr == map) || !(map->contains(x, y)))
+			break;
+
+		bret = true;
+		MyMapEditor editor(*map);
+		if (!editor.set(x, y, type))
+			break;
+
+		if (nullptr != map->components)
+		{
+			editor.attach(MyComponents::update(*map->components, editor.map(), MyPoint{ x, y }));
+		}
+		if (nullptr != map->hierarchy)
+		{
+			editor.attach(MyHpaGraph::update(*map->hierarchy, editor.map(), { MyRect{ x, y, 1, 1 } }));
+		}
+
+		const uint64_t version = ++m_version;
+		const MyMapPtr next = editor.publish(version);
+		writer.publish(next);
+
+		const MyPoint pos{ x, y };
+		_notifyPlanners(mapid, &pos, version);
+
+		// a new road may shorten any path of the map, a new wall only breaks the paths through it
+		if (TYPE_COLLISION == type)
+			pathcache.add_collision(mapid, *next, { MyRect{ x, y, 1, 1 } }, map->version, version);
+		else
+			pathcache.erase(mapid);
+	} while (false);
+	return bret;
+}
+
+const int CAStar::_editCells(const std::wstring& mapid, const std::function<int(MyMapEditor&, std::vector<MyRect>*)>& edit)
+{
+	// beyond this many changed cells the planners start over instead of repairing cell by cell
+	constexpr size_t kMaxPlannerChanges = 4096;
+	// beyond this many changed cells the component labels are rebuilt instead of updated cell by cell
+	constexpr size_t kMaxLabelUpdates = 64;
+
+	MyMapRegistry::Writer writer = global_maps.write(mapid, false);
+	const MyMapPtr map = writer.current();
+	if (nullptr == map)
+		return -1;
+
+	MyMapEditor editor(*map);
+	std::vector<MyRect> written;
+	const int changed = edit(editor, &written);
+	if (changed <= 0)
+		return 0;
+
+	// keep the parts inside the map, many small rectangles are merged into their bounding box
+	constexpr size_t kMaxDirtyRects = 64;
+	std::vector<MyRect> dirty;
+	MyRect bounds{ map->width, map->height, 0, 0 };
+	for (const MyRect& rect : written)
+	{
+		const int x0 = (std::max)(rect.x, 0);
+		const int y0 = (std::max)(rect.y, 0);
+		const int x1 = static_cast<int>((std::min)(static_cast<int64_t>(rect.x) + rect.w, static_cast<int64_t>(map->width)));
+		const int y1 = static_cast<int>((std::min)(static_cast<int64_t>(rect.y) + rect.h, static_cast<int64_t>(map->height)));
+		if ((x0 >= x1) || (y0 >= y1))
+			continue;
+
+		dirty.push_back(MyRect{ x0, y0, x1 - x0, y1 - y0 });
+		bounds.w = (std::max)(bounds.x + bounds.w, x1);
+		bounds.h = (std::max)(bounds.y + bounds.h, y1);
+		bounds.x = (std::min)(bounds.x, x0);
+		bounds.y = (std::min)(bounds.y, y0);
+		bounds.w -= bounds.x;
+		bounds.h -= bounds.y;
+	}
+	if (dirty.size() > kMaxDirtyRects)
+		dirty.assign(1, bounds);
+
+	// compare the written rows of both versions to find the cells that changed and whether any wall was removed
+	std::vector<MyPoint> cells;
+	bool opened = false;
+	for (const MyRect& rect : dirty)
+	{
+		for (int y = rect.y; y < rect.y + rect.h; ++y)
+		{
+			const uint64_t* before = map->row(y);
+			const uint64_t* after = editor.map().row(y);
+			if (before == after)
+				continue;
+
+			for (int w = rect.x >> 6; w <= ((rect.x + rect.w - 1) >> 6); ++w)
+			{
+				uint64_t diff = before[w] ^ after[w];
+				opened = opened || ((diff & after[w]) != 0);
+				while ((diff != 0) && (cells.size() <= kMaxPlannerChanges))
+				{
+					cells.push_back(MyPoint{ (w << 6) + std::countr_zero(diff), y });
+					diff &= diff - 1;
+				}
+			}
+		}
+	}
+
+	// a few cells are applied to the labels one at a time, each update only walks the regions around its cell
+	// a larger batch publishes the map without labels and they are rebuilt in the background
+	bool deferLabels = false;
+	if ((nullptr != map->components) && (cells.size() <= kMaxLabelUpdates))
+	{
+		MyMapEditor steps(*map);
+		std::shared_ptr<const MyComponents> labels = map->components;
+		for (const MyPoint& pos : cells)
+		{
+			std::ignore = steps.set(pos.x(), pos.y(), editor.map().is_road(pos.x(), pos.y()) ? TYPE_ROAD : TYPE_COLLISION);
+			labels = MyComponents::update(*labels, steps.map(), pos);
+		}
+		editor.attach(std::move(labels));
+	}
+	else if (nullptr != map->components)
+	{
+		deferLabels = true;
+	}
+	if (nullptr != map->hierarchy)
+	{
+		editor.attach(MyHpaGraph::update(*map->hierarchy, editor.map(), dirty));
+	}
+
+	const uint64_t version = ++m_version;
+	const MyMapPtr next = editor.publish(version);
+	writer.publish(next);
+
+	if (cells.size() > kMaxPlannerChanges)
+	{
+		_notifyPlanners(mapid, nullptr, version);
+	}
+	else
+	{
+		for (const MyPoint& pos : cells)
+			_notifyPlanners(mapid, &pos, version);
+	}
+
+	if (opened)
+		pathcache.erase(mapid);
+	else
+		pathcache.add_collision(mapid, *next, dirty, map->version, version);
+
+	// the task takes the write lock of the map itself
+	if (deferLabels)
+	{
+		writer = MyMapRegistry::Writer();
+		_buildComponentsLater(mapid);
+	}
+
+	return changed;
+}
+
+const int CAStar::_fillRect(const std::wstring& mapid, const MyRect& rect, const OBJECTTYPE type)
+{
+	return _editCells(mapid, [&rect, type](MyMapEditor& editor, std::vector<MyRect>* dirty)
+		{
+			dirty->push_back(rect);
+			return editor.fill(rect, type);
+		});
+}
+
+const int CAStar::_setSpans(const std::wstring& mapid, const std::vector<MySpan>& spans)
+{
+	return _editCells(mapid, [&spans](MyMapEditor& editor, std::vector<MyRect>* dirty)
+		{
+			int changed = 0;
+			for (const MySpan& span : spans)
+			{
+				const MyRect rect{ span.x, span.y, span.length, 1 };
+				dirty->push_back(rect);
+				changed += editor.fill(rect, span.type);
+			}
+			return changed;
+		});
+}
+
+const int CAStar::_blitMask(const std::wstring& mapid, const MyRect& rect, const uint8_t* bits, const size_t pitch)
+{
+	return _editCells(mapid, [&rect, bits, pitch](MyMapEditor& editor, std::vector<MyRect>* dirty)
+		{
+			dirty->push_back(rect);
+			return editor.blit(rect, bits, pitch);
+		});
+}
+
+const bool CAStar::_createNewMap(const std::wstring& mapid, const int w, const int h)
+{
+	bool bret = false;
+	do
+	{
+		if (((w) <= 0) || ((h) <= 0))
+			break;
+
+		MyMapEditor editor(w, h, TYPE_ROAD);
+		_publishNew(mapid, editor);
+		bret = true;
+	} while (false);
+	return bret;
+}
+
+const bool CAStar::_freeMap(const std::wstring& mapid)
+{
+	{
+		MyMapRegistry::Writer writer = global_maps.write(mapid, false);
+		writer.publish(nullptr);
+	}
+	flowfields.erase(mapid);
+	pathcache.erase(mapid);
+	MyPrintQueue::instance().forget(mapid);
+	{
+		std::unique_lock<std::shared_mutex> lck(m_mutex);
+		map_engines.erase(mapid);
+	}
+	{
+		std::lock_guard<std::mutex> lck(m_plannerMutex);
+		std::erase_if(planners, [&mapid](const auto& it) { return it.second.mapid == mapid; });
+	}
+	return true;
+}
+
+const bool CAStar::_addCollision(const std::wstring& mapid, const int x, const int y)
+{
+	return _setCell(mapid, x, y, TYPE_COLLISION);
+}
+
+const bool CAStar::_removeCollision(const std::wstring& mapid, const int x, const int y)
+{
+	return _setCell(mapid, x, y, TYPE_ROAD);
+}
+
+const int CAStar::_printMap(const std::wstring& mapid, const std::wstring& fileName)
+{
+	const MyMapPtr ptr = _snapshot(mapid);
+	if (nullptr == ptr)
+		return 0;
+
+	return my_write_image(*my_render_map(*ptr, roadColor, wallColor), fileName) ? 1 : 0;
+}
+
+void CAStar::_autoPrint(const std::wstring& mapid, const MyMapPtr& map, const std::vector<MyPoint>& path)
+{
+	std::wstring fileName;
+	if (this->outputdir.empty())
+	{
+		WCHAR szFilePath[MAX_PATH + 1];
+		GetModuleFileName(NULL, szFilePath, MAX_PATH);
+		(wcsrchr(szFilePath, TEXT('\\')))[1] = '\0';//replace '\\' to '\0'
+
+		fileName = std::format(TEXT(R"({}\{}.bmp)"), szFilePath, mapid);
+	}
+	else
+	{
+		fileName = std::format(TEXT(R"({}\{}.bmp)"), this->outputdir, mapid);
+	}
+
+	(void)MyPrintQueue::instance().push(MyPrintQueue::Job{ mapid, map, path, roadColor, wallColor, pathColor, std::move(fileName) });
+}
+
+void CAStar::_setWallColor(const MyRGB& rbg)
+{
+	wallColor = rbg;
+}
+
+void CAStar::_setRoadColor(const MyRGB& rbg)
+{
+	roadColor = rbg;
+}
+
+void CAStar::_setPathColor(const MyRGB& rbg)
+{
+	pathColor = rbg;
+}
+
+const int CAStar::_setOutputDirectory(const std::wstring& dir)
+{
+	this->outputdir = dir;
+	return !dir.empty();
+}
+
+const int CAStar::_mapSaveAs(const std::wstring& mapid, const std::wstring& fileName)
+{
+	const MyMapPtr ptr = _snapshot(mapid);
+	if (nullptr == ptr)
+	{
+		return 0;
+	}
+
+	return my_map_save(*ptr, fileName) ? 1 : -1;
+}
+
+const int CAStar::_mapLoadFrom(const std::wstring& mapid, const std::wstring& fileName)
+{
+	// the mapped format is used in place, the labels follow in the background
+	if (my_map_is_mapped_file(fileName))
+	{
+		const std::shared_ptr<MyMap> loaded = my_map_load(fileName, verifymapfiles);
+		if (nullptr == loaded)
+		{
+			return -1;
+		}
+
+		MyMapEditor editor(*loaded);
+		_publishNew(mapid, editor, true);
+		return 1;
+	}
+
+	// the old .dat format: width, height and a column-major body of one byte per cell
+	std::ifstream ifs(fileName, std::ios::binary);
+	if (!ifs.is_open())
+	{
+		return -1;
+	}
+
+	int width = 0;
+	int height = 0;
+
+	ifs.read(reinterpret_cast<char*>(&width), sizeof(width));
+	ifs.read(reinterpret_cast<char*>(&height), sizeof(height));
+	if ((width <= 0) || (height <= 0))
+	{
+		return -1;
+	}
+
+	std::vector<uint8_t> body(static_cast<size_t>(width) * height, static_cast<uint8_t>(TYPE_ROAD));
+	ifs.read(reinterpret_cast<char*>(body.data()), body.size());
+	ifs.close();
+
+	MyMapEditor editor(width, height, TYPE_COLLISION);
+
+	// transpose straight into the words of each row
+	int x = 0;
+	for (int y = 0; y < height; ++y)
+	{
+		uint64_t* row = editor.mutable_row(y);
+		for (x = 0; x < width; ++x)
+		{
+			if (TYPE_ROAD == body[static_cast<size_t>(x) * height + y])
+				row[x >> 6] |= 1ULL << (x & 63);
+		}
+	}
+
+	_publishNew(mapid, editor);
+	return 1;
+}
+
+const int CAStar::_isCell(const std::wstring& mapid, const int x, const int y, const OBJECTTYPE type)
+{
+	const MyMapPtr ptr = _snapshot(mapid);
+	if (nullptr == ptr)
+		return -1;
+
+	return (ptr->contains(x, y) && (ptr->at(x, y) == type)) ? 1 : 0;
+}
+
+const int CAStar::_testCells(const std::wstring& mapid, const std::vector<MyPoint>& points, const OBJECTTYPE type, uint8_t* bits)
+{
+	const MyMapPtr ptr = _snapshot(mapid);
+	if (nullptr == ptr)
+		return -1;
+
+	return ptr->test(points.data(), static_cast<int>(points.size()), type, bits);
+}
+
+const int CAStar::_getRoads(const std::wstring& mapid, std::vector<MyPoint>* v)
+{
+	const MyMapPtr ptr = _snapshot(mapid);
+	if (nullptr == ptr)
+		return 0;
+
+	const MyMap& map = *ptr;
+	int x = 0;
+	for (int y = 0; y < map.height; ++y)
+	{
+		for (x = 0; x < map.width; ++x)
+		{
+			if (map.is_road(x, y))
+			{
+				v->push_back(MyPoint{ x, y });
+			}
+		}
+	}
+	return v->size();
+}
+
+const int CAStar::_getCollisions(const std::wstring& mapid, std::vector<MyPoint>* v)
+{
+	const MyMapPtr ptr = _snapshot(mapid);
+	if (nullptr == ptr)
+		return 0;
+
+	const MyMap& map = *ptr;
+	int x = 0;
+	for (int y = 0; y < map.height; ++y)
+	{
+		for (x = 0; x < map.width; ++x)
+		{
+			if (!map.is_road(x, y))
+			{
+				v->push_back(MyPoint{ x, y });
+			}
+		}
+	}
+
+	return v->size();
+}
+
+const int CAStar::_readBMPToBinary(const std::wstring& mapid, const std::wstring& fileName)
+{
+	MyBitmapReader reader;
+	if (!reader.open(fileName))
+		return 0;
+
+	MyMapEditor editor(reader.width(), reader.height(), TYPE_ROAD);
+	if (!reader.read(&editor, wallColor))
+		return 0;
+
+	_publishNew(mapid, editor, true);
+	return 1;
 }
\ No newline at end of file
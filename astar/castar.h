@@ -1,124 +1,319 @@
-﻿/*
-* Copyright (c) 2019-2022 bestkakkoii llc.
-*
-* This software is provided 'as-is', without any express or implied
-* warranty.  In no event will the authors be held liable for any damages
-* arising from the use of this software.
-* Permission is granted to anyone to use this software for any purpose,
-* including commercial applications, and to alter it and redistribute it
-* freely, subject to the following restrictions:
-* 1. The origin of this software must not be misrepresented; you must not
-* claim that you wrote the original software. If you use this software
-* in a product, an acknowledgment in the product documentation would be
-* appreciated but is not required.
-* 2. Altered source versions must be plainly marked as such, and must not be
-* misrepresented as being the original software.
-* 3. This notice may not be removed or altered from any source distribution.
-*/
-#pragma once
-#ifndef CASTAR_H
-#define CASTAR_H
-#include "myastar.h"
-
-class CAStar
-{
-	MY_DISABLE_COPY_MOVE(CAStar) // make sure it is a singleton pattern
-private:
-	// function locker for multi-thread
-	mutable std::shared_mutex m_mutex;
-	//map data
-	std::unordered_map<std::wstring, MyMap> global_maps = {};
-
-	// default color
-	MyRGB wallColor = { 0, 0, 0 };
-	MyRGB roadColor = { 255, 255, 255 };
-	MyRGB pathColor = { 234, 103, 105 };
-
-	// enable output bitmap when path found
-	bool enableautoprint;
-
-	// enable 8-dir otherwise 4-dir
-	bool cornerenable;
-
-	// the path where you save the bitmap with path highlight
-	std::wstring outputdir;
-
-	explicit CAStar()
-		: cornerenable(true)
-		, enableautoprint(false)
-		, outputdir(TEXT("\0"))
-	{
-	}
-
-public:
-	virtual ~CAStar() {
-	}
-
-#define CASTAR_INS CAStar::get_instance();
-	static CAStar& get_instance() {
-		static CAStar instance;
-		return instance;
-	}
-
-	// set enable or disable auto print
-	const int __vectorcall _enableAutoPrint(const bool b)
-	{
-		enableautoprint = b;
-		return 1;
-	}
-
-	// set enable or disable corner allow
-	MY_REQUIRED_RESULT const int __vectorcall _enableCorner(const bool b)
-	{
-		std::unique_lock<std::shared_mutex> lck(m_mutex);
-		cornerenable = b;
-		return 1;
-	}
-
-	// start finding path
-	MY_REQUIRED_RESULT const int __vectorcall _start(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v);
-
-	// insert a new empty map in to unordered_map pretent all points are passable
-	const bool __vectorcall _createNewMap(const std::wstring& mapid, const int w, const int h);
-
-	// erase map from unordered_map
-	MY_REQUIRED_RESULT const bool __vectorcall _freeMap(const std::wstring& mapid);
-
-	// mark as non-passable to the sepcific point
-	const bool __vectorcall _addCollision(const std::wstring& mapid, const int x, const int y);
-
-	// mark as passable to the sepcific point
-	const bool __vectorcall _removeCollision(const std::wstring& mapid, const int x, const int y);
-
-	// output the map to bitmap file
-	MY_REQUIRED_RESULT const int __vectorcall _printMap(const std::wstring& mapid, const std::wstring& fileName);
-
-	// set the color of the wall
-	void __vectorcall _setWallColor(const MyRGB& rbg);
-
-	// set the color of the road
-	void __vectorcall _setRoadColor(const MyRGB& rbg);
-
-	// set the color of the path
-	void __vectorcall _setPathColor(const MyRGB& rbg);
-
-	// set the output directory
-	MY_REQUIRED_RESULT const int __vectorcall _setOutputDirectory(const std::wstring& dir);
-
-	// save the map to the binary(.dat) file
-	MY_REQUIRED_RESULT const int __vectorcall _mapSaveAs(const std::wstring& mapid, const std::wstring& fileName);
-
-	// load the map from the binary(.dat) file
-	MY_REQUIRED_RESULT const int __vectorcall _mapLoadFrom(const std::wstring& mapid, const std::wstring& fileName);
-
-	// get all passable points
-	MY_REQUIRED_RESULT const int __vectorcall _getRoads(const std::wstring& mapid, std::vector<MyPoint>* v);
-
-	// get all non-passable points
-	MY_REQUIRED_RESULT const int __vectorcall _getCollisions(const std::wstring& mapid, std::vector<MyPoint>* v);
-
-	// load map from the bitmap file
-	MY_REQUIRED_RESULT const int __vectorcall _readBMPToBinary(const std::wstring& mapid, const std::wstring& fileName);
-};
-
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef CASTAR_H
+#define CASTAR_H
+#include "myastar.h"
+#include "myjps.h"
+#include "myhpa.h"
+#include "mycomponents.h"
+#include "mythreadpool.h"
+#include "myflowfield.h"
+#include "mypathcache.h"
+#include "mydstar.h"
+#include "mymap.h"
+#include "mymapregistry.h"
+#include "mymapfile.h"
+#include "mybitmap.h"
+#include "myprintqueue.h"
+#include "mysearch.h"
+
+class CAStar
+{
+	MY_DISABLE_COPY_MOVE(CAStar) // make sure it is a singleton pattern
+private:
+	// guards the engine settings, the flags below are atomic and read once per call
+	mutable std::shared_mutex m_mutex;
+	//map data, every map has its own write lock and its latest immutable version
+	MyMapRegistry global_maps;
+	// last version number handed out, unique across all maps
+	std::atomic<uint64_t> m_version = 0;
+
+	// default color
+	MyRGB wallColor = { 0, 0, 0 };
+	MyRGB roadColor = { 255, 255, 255 };
+	MyRGB pathColor = { 234, 103, 105 };
+
+	// enable output bitmap when path found
+	std::atomic<bool> enableautoprint;
+
+	// enable 8-dir otherwise 4-dir
+	std::atomic<bool> cornerenable;
+
+	// build the JPS+ table whenever a whole map is created or loaded
+	std::atomic<bool> enablejumptable;
+
+	// check the whole body of a mapped map file against its checksum before using it
+	std::atomic<bool> verifymapfiles;
+
+	// engine used when neither the query nor the map picks one
+	ENGINETYPE defaultengine;
+
+	// engine picked per map, guarded by m_mutex
+	std::unordered_map<std::wstring, ENGINETYPE> map_engines = {};
+
+	// flow fields shared by the agents heading for the same goal
+	MyFlowCache flowfields;
+
+	// repeated queries, disabled until a budget is set
+	MyPathCache pathcache;
+
+	// D* Lite planners by handle, each one follows the edits of its map, guarded by m_plannerMutex
+	struct Planner
+	{
+		std::wstring mapid;
+		std::shared_ptr<MyDStarLite> planner;
+	};
+	std::mutex m_plannerMutex;
+	std::unordered_map<int, Planner> planners = {};
+	int m_lastPlanner = 0;
+
+	// searches run a slice at a time by handle, guarded by m_searchMutex
+	std::mutex m_searchMutex;
+	std::unordered_map<int, std::shared_ptr<MySearch>> searches = {};
+	int m_lastSearch = 0;
+
+	// the path where you save the bitmap with path highlight
+	std::wstring outputdir;
+
+	explicit CAStar()
+		: cornerenable(true)
+		, enablejumptable(false)
+		, verifymapfiles(false)
+		, defaultengine(ENGINE_ASTAR)
+		, enableautoprint(false)
+		, outputdir(TEXT("\0"))
+	{
+	}
+
+	// pin the current version of the map, nullptr if the map does not exist
+	MY_REQUIRED_RESULT MyMapPtr __vectorcall _snapshot(const std::wstring& mapid) const;
+
+	// publish a freshly created or loaded map with its component labels, and its JPS+ table if enabled
+	// with deferLabels the map is published at once and the labels are attached in the background
+	void __vectorcall _publishNew(const std::wstring& mapid, MyMapEditor& editor, const bool deferLabels = false);
+
+	// build the component labels of the latest version in the background and attach them to it
+	void __vectorcall _buildComponentsLater(const std::wstring& mapid);
+
+	// resolve ENGINE_DEFAULT to the engine set for the map
+	MY_REQUIRED_RESULT ENGINETYPE __vectorcall _engineOf(const std::wstring& mapid, const ENGINETYPE engine) const;
+
+	// run one query on a pinned version of a map through the path cache, safe to call from any thread
+	MY_REQUIRED_RESULT const SEARCHSTATUS __vectorcall _search(const std::wstring& mapid, const MyMap& grid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v, const ENGINETYPE engine, const MyBudget& budget = MyBudget{});
+
+	// queue the bitmap of the map with the path highlighted, the file is written in the background
+	void __vectorcall _autoPrint(const std::wstring& mapid, const MyMapPtr& map, const std::vector<MyPoint>& path);
+
+	// tell the planners of the map about an edited cell, or that the map was replaced if pos is nullptr
+	void __vectorcall _notifyPlanners(const std::wstring& mapid, const MyPoint* pos, const uint64_t version);
+
+	// publish a new version with one cell changed
+	const bool __vectorcall _setCell(const std::wstring& mapid, const int x, const int y, const OBJECTTYPE type);
+
+	// run a batch of edits on one editor and publish it as a single version
+	// edit returns the number of changed cells and adds the rectangles it wrote to
+	// return the number of changed cells, -1 if the map does not exist
+	const int __vectorcall _editCells(const std::wstring& mapid, const std::function<int(MyMapEditor&, std::vector<MyRect>*)>& edit);
+
+public:
+	virtual ~CAStar() {
+	}
+
+#define CASTAR_INS CAStar::get_instance();
+	static CAStar& get_instance() {
+		static CAStar instance;
+		return instance;
+	}
+
+	// set enable or disable auto print
+	const int __vectorcall _enableAutoPrint(const bool b)
+	{
+		enableautoprint = b;
+		return 1;
+	}
+
+	// set enable or disable corner allow
+	MY_REQUIRED_RESULT const int __vectorcall _enableCorner(const bool b)
+	{
+		cornerenable = b;
+		return 1;
+	}
+
+	// set the search engine of the map, an empty mapid sets the default engine of all maps
+	MY_REQUIRED_RESULT const int __vectorcall _setEngine(const std::wstring& mapid, const ENGINETYPE engine);
+
+	// set enable or disable building the JPS+ table when a map is created or loaded
+	const int __vectorcall _enableJumpTable(const bool b)
+	{
+		enablejumptable = b;
+		return 1;
+	}
+
+	// set enable or disable the checksum of the whole file when a mapped map file is loaded
+	const int __vectorcall _enableMapChecksum(const bool b)
+	{
+		verifymapfiles = b;
+		return 1;
+	}
+
+	// build the JPS+ table of the current version, it is dropped again by the next edit
+	MY_REQUIRED_RESULT const int __vectorcall _buildJumpTable(const std::wstring& mapid);
+
+	// build the HPA* graph of the current version for the current connectivity,
+	// later collision edits rebuild only the clusters around the edited cells
+	MY_REQUIRED_RESULT const int __vectorcall _buildHierarchy(const std::wstring& mapid, const int clusterSize);
+
+	// search the HPA* graph only, the waypoints start with the start point and end with the end point
+	// every pair of consecutive waypoints can be refined later by _refineSegment
+	MY_REQUIRED_RESULT const int __vectorcall _startAbstract(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v);
+
+	// refine one segment of the waypoints from _startAbstract to cells, excluding its start point
+	MY_REQUIRED_RESULT const int __vectorcall _refineSegment(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v);
+
+	// check the two points are passable and connected without searching, flooding the map while its labels are pending
+	// return 1 if connected, 0 if not, -1 if the map does not exist or a point is outside it
+	MY_REQUIRED_RESULT const int __vectorcall _isConnected(const std::wstring& mapid, const MyPoint& a, const MyPoint& b);
+
+	// start finding path, ENGINE_DEFAULT uses the engine set for the map
+	// a limited budget runs the query on A*, which stops on the first limit hit with the path to the node closest to the end
+	// return the SEARCHSTATUS, 1 if found, 0 if not
+	MY_REQUIRED_RESULT const int __vectorcall _start(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, std::vector<MyPoint>* v, const ENGINETYPE engine = ENGINE_DEFAULT, const MyBudget& budget = MyBudget{});
+
+	// find a path that costs at most (1 + bound.epsilon) times the shortest one, ratio may be nullptr
+	// ratio receives the cost of the path over a lower bound of the shortest one, the path cache is not used
+	// return 1 if found, 0 if not, -1 if the bound is invalid
+	MY_REQUIRED_RESULT const int __vectorcall _startBounded(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint, const MyBound& bound, std::vector<MyPoint>* v, double* ratio);
+
+	// build or reuse the flow field of the goal for the current version and corner setting
+	MY_REQUIRED_RESULT const int __vectorcall _buildFlowField(const std::wstring& mapid, const MyPoint& goal);
+
+	// read the path to the goal from its flow field, the field is built on first use
+	MY_REQUIRED_RESULT const int __vectorcall _startFlow(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& goal, std::vector<MyPoint>* v);
+
+	// get the next cell towards the goal from its flow field, the field is built on first use
+	MY_REQUIRED_RESULT const int __vectorcall _flowNextStep(const std::wstring& mapid, const MyPoint& goal, const MyPoint& pos, MyPoint* next);
+
+	// set the byte budget of the path cache, 0 disables it
+	const int __vectorcall _setPathCacheBudget(const size_t bytes)
+	{
+		pathcache.set_budget(bytes);
+		return 1;
+	}
+
+	// get the hit/miss counters and the size of the path cache
+	MY_REQUIRED_RESULT MyPathCache::Stats __vectorcall _getPathCacheStats() const
+	{
+		return pathcache.stats();
+	}
+
+	// create a D* Lite planner for the goal on the map with the current corner setting
+	// return the handle, 0 if the map does not exist
+	MY_REQUIRED_RESULT const int __vectorcall _createPlanner(const std::wstring& mapid, const MyPoint& goal);
+
+	// bring the planner up to date with the edits of its map and get the path from the start to its goal
+	// return 1 if found, 0 if not, -1 if the handle does not exist
+	MY_REQUIRED_RESULT const int __vectorcall _replan(const int handle, const MyPoint& startPoint, std::vector<MyPoint>* v);
+
+	// release the planner
+	MY_REQUIRED_RESULT const int __vectorcall _destroyPlanner(const int handle);
+
+	// set up an A* query on the current version of the map with the current corner setting, run by _stepSearch
+	// return the handle, 0 if the map does not exist
+	MY_REQUIRED_RESULT const int __vectorcall _createSearch(const std::wstring& mapid, const MyPoint& startPoint, const MyPoint& endPoint);
+
+	// run the search for one slice and get the path if v is not nullptr, a partial one while it is in progress
+	// return the SEARCHSTATUS, SEARCH_EXPANSIONS or SEARCH_TIMEOUT while in progress, -1 if the handle does not exist
+	MY_REQUIRED_RESULT const int __vectorcall _stepSearch(const int handle, const MyBudget& budget, std::vector<MyPoint>* v);
+
+	// release the search
+	MY_REQUIRED_RESULT const int __vectorcall _destroySearch(const int handle);
+
+	// run independent queries in parallel on the thread pool, every map is pinned once for the whole batch
+	// path i is points[offsets[i]] .. points[offsets[i + 1] - 1], found[i] is 1 if the query found a path
+	// return the number of queries that found a path
+	MY_REQUIRED_RESULT const int __vectorcall _startBatch(const std::vector<MyQuery>& queries, std::vector<MyPoint>* points, std::vector<int>* offsets, std::vector<uint8_t>* found);
+
+	// destroy the search handles, stop the background threads and write the queued printouts before the library is unloaded, static destructors run under the loader lock
+	// where waiting for a thread can deadlock, later calls still work but run on the calling thread
+	const int __vectorcall _shutdown();
+
+	// insert a new empty map in to unordered_map pretent all points are passable
+	const bool __vectorcall _createNewMap(const std::wstring& mapid, const int w, const int h);
+
+	// erase map from unordered_map, together with its planners
+	MY_REQUIRED_RESULT const bool __vectorcall _freeMap(const std::wstring& mapid);
+
+	// mark as non-passable to the sepcific point
+	const bool __vectorcall _addCollision(const std::wstring& mapid, const int x, const int y);
+
+	// mark as passable to the sepcific point
+	const bool __vectorcall _removeCollision(const std::wstring& mapid, const int x, const int y);
+
+	// set every cell of the rectangle to the type as one edit
+	// return the number of changed cells, -1 if the map does not exist
+	const int __vectorcall _fillRect(const std::wstring& mapid, const MyRect& rect, const OBJECTTYPE type);
+
+	// apply the runs as one edit, later runs win where they overlap
+	// return the number of changed cells, -1 if the map does not exist
+	const int __vectorcall _setSpans(const std::wstring& mapid, const std::vector<MySpan>& spans);
+
+	// copy a collision bitmask onto the rectangle as one edit, see MyMapEditor::blit for the mask layout
+	// return the number of changed cells, -1 if the map does not exist
+	const int __vectorcall _blitMask(const std::wstring& mapid, const MyRect& rect, const uint8_t* bits, const size_t pitch);
+
+	// output the map to bitmap file
+	MY_REQUIRED_RESULT const int __vectorcall _printMap(const std::wstring& mapid, const std::wstring& fileName);
+
+	// set the color of the wall
+	void __vectorcall _setWallColor(const MyRGB& rbg);
+
+	// set the color of the road
+	void __vectorcall _setRoadColor(const MyRGB& rbg);
+
+	// set the color of the path
+	void __vectorcall _setPathColor(const MyRGB& rbg);
+
+	// set the output directory
+	MY_REQUIRED_RESULT const int __vectorcall _setOutputDirectory(const std::wstring& dir);
+
+	// save the map to a file in the mapped format (mymapfile.h)
+	MY_REQUIRED_RESULT const int __vectorcall _mapSaveAs(const std::wstring& mapid, const std::wstring& fileName);
+
+	// load the map from a file in the mapped format, used in place, or from an old binary(.dat) file
+	MY_REQUIRED_RESULT const int __vectorcall _mapLoadFrom(const std::wstring& mapid, const std::wstring& fileName);
+
+	// check one cell of the latest version, return 1 if it is of the type, 0 if not or outside the map, -1 if the map does not exist
+	MY_REQUIRED_RESULT const int __vectorcall _isCell(const std::wstring& mapid, const int x, const int y, const OBJECTTYPE type);
+
+	// check many cells of one version, see MyMap::test for the mask layout
+	// return the number of points of the type, -1 if the map does not exist
+	MY_REQUIRED_RESULT const int __vectorcall _testCells(const std::wstring& mapid, const std::vector<MyPoint>& points, const OBJECTTYPE type, uint8_t* bits);
+
+	// get all passable points
+	MY_REQUIRED_RESULT const int __vectorcall _getRoads(const std::wstring& mapid, std::vector<MyPoint>* v);
+
+	// get all non-passable points
+	MY_REQUIRED_RESULT const int __vectorcall _getCollisions(const std::wstring& mapid, std::vector<MyPoint>* v);
+
+	// load map from an uncompressed 1, 4, 8, 24 or 32-bit bitmap file, row y of the picture is row y of the map
+	// pixels of the wall colour become collisions and every other pixel becomes road
+	MY_REQUIRED_RESULT const int __vectorcall _readBMPToBinary(const std::wstring& mapid, const std::wstring& fileName);
+};
+
 #endif
\ No newline at end of file
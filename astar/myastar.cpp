@@ -1,291 +1,705 @@
-﻿#include "myastar.h"
-
-constexpr int kStepValue = 10;
-constexpr int kObliqueValue = 14;
-
-MyAStar::MyAStar(BlockAllocator* allocator)
-	: width_(0)
-	, height_(0)
-	, allocator_(allocator)
-	, step_val_(kStepValue)
-	, oblique_val_(kObliqueValue)
-{
-}
-
-MyAStar::~MyAStar()
-{
-	clear();
-}
-
-constexpr int MyAStar::get_step_value() const
-{
-	return step_val_;
-}
-
-constexpr int MyAStar::get_oblique_value() const
-{
-	return oblique_val_;
-}
-
-void MyAStar::clear()
-{
-	int index = 0;
-	const int max_size = width_ * height_;
-	while ((index) < (max_size))
-	{
-		allocator_->free(mapping_[index++], sizeof(Node));
-	}
-	open_list_.clear();
-	can_pass_ = nullptr;
-	width_ = height_ = 0;
-}
-
-void MyAStar::init(const MyParams& param)
-{
-	width_ = param.width;
-	height_ = param.height;
-	can_pass_ = param.can_pass;
-	mapping_.clear();
-	mapping_.resize(width_ * height_);
-	memset(&mapping_[0], 0, sizeof(Node*) * mapping_.size());
-}
-
-const bool MyAStar::is_vlid_params(const MyParams& param) const
-{
-	return (((param.can_pass) != nullptr)
-		&& (((param.width) > 0) && ((param.height) > 0))
-		&& (((param.end.x()) >= 0) && ((param.end.x()) < (param.width)))
-		&& (((param.end.y()) >= 0) && ((param.end.y()) < (param.height)))
-		&& (((param.start.x()) >= 0) && ((param.start.x()) < (param.width)))
-		&& (((param.start.y()) >= 0) && ((param.start.y()) < (param.height)))
-		);
-}
-
-const bool MyAStar::get_node_index(Node*& node, int* index)  const
-{
-	*index = 0;
-	const int size = static_cast<int>(open_list_.size());
-	while (*index < (size))
-	{
-		if (open_list_[*index]->pos == node->pos)
-		{
-			return true;
-		}
-		++(*index);
-	}
-	return false;
-}
-
-constexpr void MyAStar::percolate_up(int hole)
-{
-	int parent = 0;
-	while ((hole) > 0)
-	{
-		parent = ((hole)-1) / 2;
-		if (open_list_[hole]->f() < open_list_[parent]->f())
-		{
-			std::ranges::swap(open_list_[hole], open_list_[parent]);
-			hole = parent;
-		}
-		else
-		{
-			return;
-		}
-	}
-}
-
-__forceinline const int MyAStar::calcul_g_value(Node* parent, const MyPoint& current) const
-{
-	int g_value = (current - parent->pos).manhattanLength() == 2 ? oblique_val_ : step_val_;
-	return g_value += parent->g;
-}
-
-__forceinline const int MyAStar::calcul_h_value(const MyPoint& current, const MyPoint& end) const
-{
-	int h_value = (end - current).manhattanLength();
-	return h_value * step_val_;
-}
-
-__forceinline constexpr bool MyAStar::in_open_list(const MyPoint& pos, Node*& out_node) const
-{
-	out_node = mapping_[pos.y() * width_ + pos.x()];
-	return out_node ? (out_node->state == IN_OPENLIST) : false;
-}
-
-__forceinline constexpr bool MyAStar::in_closed_list(const MyPoint& pos) const
-{
-	Node* node_ptr = mapping_[pos.y() * width_ + pos.x()];
-	return node_ptr ? (node_ptr->state == IN_CLOSEDLIST) : false;
-}
-
-bool MyAStar::can_pass(const MyPoint& pos)
-{
-	return (((pos.x()) >= 0) && ((pos.x()) < (width_)) && ((pos.y()) >= 0) && ((pos.y()) < height_)) ? can_pass_(pos) : false;
-}
-
-bool MyAStar::can_pass(const MyPoint& current, const MyPoint& destination, const bool allow_corner)
-{
-	if (((destination.x()) >= 0) && ((destination.x()) < (width_)) && ((destination.y()) >= 0) && ((destination.y()) < (height_)))
-	{
-		if (in_closed_list(destination))
-		{
-			return false;
-		}
-
-		if ((destination - current).manhattanLength() == 1)
-		{
-			return can_pass_(destination);
-		}
-		else if (allow_corner)
-		{
-			return can_pass_(destination) &&
-				can_pass(MyPoint{ static_cast<int>(current.x() + destination.x() - current.x()), current.y() }) &&
-				can_pass(MyPoint{ current.x(), static_cast<int>(current.y() + destination.y() - current.y()) });
-		}
-	}
-	return false;
-}
-
-void MyAStar::find_can_pass_nodes(const MyPoint& current, const bool corner, std::vector<MyPoint>* out_lists)
-{
-	MyPoint destination = {};
-	int row_index = current.y() - 1;
-	const int max_row = current.y() + 1;
-	const int max_col = current.x() + 1;
-
-	if (row_index < 0)
-	{
-		row_index = 0;
-	}
-
-	while ((row_index) <= (max_row))
-	{
-		int col_index = current.x() - 1;
-
-		if (col_index < 0)
-		{
-			col_index = 0;
-		}
-
-		while ((col_index) <= (max_col))
-		{
-			destination.reset(col_index, row_index);
-			if (can_pass(current, destination, corner))
-			{
-				out_lists->push_back(destination);
-			}
-			++col_index;
-		}
-		++row_index;
-	}
-}
-
-void MyAStar::handle_found_node(Node*& current, Node*& destination)
-{
-	int g_value = calcul_g_value(current, destination->pos);
-	if ((g_value) < (destination->g))
-	{
-		destination->g = g_value;
-		destination->parent = current;
-
-		int index = 0;
-		if (get_node_index(destination, &index)) [[likely]]
-		{
-			percolate_up(index);
-		}
-		else [[unlikely]]
-		{
-			assert(false);
-		}
-	}
-}
-
-void MyAStar::handle_not_found_node(Node*& current, Node*& destination, const MyPoint& end)
-{
-	destination->parent = current;
-	destination->h = calcul_h_value(destination->pos, end);
-	destination->g = calcul_g_value(current, destination->pos);
-
-	Node*& reference_node = mapping_[destination->pos.y() * width_ + destination->pos.x()];
-	reference_node = destination;
-	reference_node->state = IN_OPENLIST;
-
-	open_list_.push_back(destination);
-	std::ranges::push_heap(open_list_, [](const Node* a, const Node* b)->bool
-		{
-			return a->f() > b->f();
-		});
-}
-
-bool MyAStar::find(const MyParams& param, std::vector<MyPoint>* path)
-{
-	if (!is_vlid_params(param))
-	{
-		return false;
-	}
-
-	// initialize
-	init(param);
-
-	std::vector<MyPoint> nearby_nodes;
-	nearby_nodes.reserve(param.corner ? 8 : 4);
-
-	// put the start node into the open list
-	Node* start_node = new (allocator_->allocate(sizeof(Node))) Node(param.start);
-	open_list_.push_back(start_node);
-	Node*& reference_node = mapping_[((start_node->pos.y()) * (width_)) + start_node->pos.x()];
-	reference_node = start_node;
-	reference_node->state = IN_OPENLIST;
-
-	// searching for the path
-	while (!open_list_.empty())
-	{
-		// pop the node with the lowest f value
-		Node* current = open_list_.front();
-		std::ranges::pop_heap(open_list_, [](const Node* a, const Node* b)->bool
-			{
-				return a->f() > b->f();
-			});
-
-		open_list_.pop_back();
-		mapping_[((current->pos.y()) * (width_)) + (current->pos.x())]->state = NodeState::IN_CLOSEDLIST;
-
-		// is the destination found?
-		if ((current->pos) == (param.end))
-		{
-			while (current->parent)
-			{
-				path->push_back(current->pos);
-				current = current->parent;
-			}
-			std::ranges::reverse(*path);
-			clear();
-			return true;
-		}
-
-		// find the nearby nodes that can be passed
-		nearby_nodes.clear();
-		find_can_pass_nodes(current->pos, param.corner, &nearby_nodes);
-
-		// calculate the cost value of the nearby nodes
-		size_t index = 0;
-		const size_t size = nearby_nodes.size();
-		while ((index) < (size))
-		{
-			Node* next_node = nullptr;
-			if (in_open_list(nearby_nodes[index], next_node))
-			{
-				handle_found_node(current, next_node);
-			}
-			else
-			{
-				next_node = new (allocator_->allocate(sizeof(Node))) Node(nearby_nodes[index]);
-				handle_not_found_node(current, next_node, param.end);
-			}
-			++index;
-		}
-	}
-
-	clear();
-	return false;
+﻿#include "myastar.h"
+
+constexpr int kStepValue = 10;
+constexpr int kObliqueValue = 14;
+
+// expansions between two reads of the clock of a timed search, a power of two
+constexpr int kClockInterval = 64;
+
+template <typename Passable, bool Corner, typename Heuristic>
+MyAStar<Passable, Corner, Heuristic>::MyAStar(MySearchContext* context, const Passable& can_pass, const Heuristic& heuristic)
+	: width_(0)
+	, height_(0)
+	, can_pass_(can_pass)
+	, heuristic_(heuristic)
+	, context_(context)
+	, open_list_(context->open_list())
+	, step_val_(kStepValue)
+	, oblique_val_(kObliqueValue)
+{
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+MyAStar<Passable, Corner, Heuristic>::~MyAStar()
+{
+	clear();
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+constexpr int MyAStar<Passable, Corner, Heuristic>::get_step_value() const
+{
+	return step_val_;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+constexpr int MyAStar<Passable, Corner, Heuristic>::get_oblique_value() const
+{
+	return oblique_val_;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+void MyAStar<Passable, Corner, Heuristic>::clear()
+{
+	open_list_.clear();
+	width_ = height_ = 0;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+void MyAStar<Passable, Corner, Heuristic>::init(const MyParams& param)
+{
+	width_ = param.width;
+	height_ = param.height;
+	context_->begin(width_, height_);
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+const bool MyAStar<Passable, Corner, Heuristic>::is_vlid_params(const MyParams& param) const
+{
+	return ((param.corner == Corner)
+		&& (((param.width) > 0) && ((param.height) > 0))
+		&& (((param.end.x()) >= 0) && ((param.end.x()) < (param.width)))
+		&& (((param.end.y()) >= 0) && ((param.end.y()) < (param.height)))
+		&& (((param.start.x()) >= 0) && ((param.start.x()) < (param.width)))
+		&& (((param.start.y()) >= 0) && ((param.start.y()) < (param.height)))
+		);
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+__forceinline const int MyAStar<Passable, Corner, Heuristic>::calcul_g_value(Node* parent, const MyPoint& current) const
+{
+	int g_value = (current - parent->pos).manhattanLength() == 2 ? oblique_val_ : step_val_;
+	return g_value += parent->g;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+__forceinline const int MyAStar<Passable, Corner, Heuristic>::calcul_h_value(const MyPoint& current, const MyPoint& end) const
+{
+	return heuristic_(std::abs(end.x() - current.x()), std::abs(end.y() - current.y()), step_val_, oblique_val_);
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+__forceinline const int MyAStar<Passable, Corner, Heuristic>::calcul_bound_value(const MyPoint& current, const MyPoint& end) const
+{
+	return MyBestHeuristic<Corner>{}(std::abs(end.x() - current.x()), std::abs(end.y() - current.y()), step_val_, oblique_val_);
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+__forceinline constexpr bool MyAStar<Passable, Corner, Heuristic>::in_open_list(const MyPoint& pos, Node*& out_node) const
+{
+	out_node = context_->node(pos.y() * width_ + pos.x());
+	return out_node ? (out_node->state == IN_OPENLIST) : false;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+__forceinline constexpr bool MyAStar<Passable, Corner, Heuristic>::in_closed_list(const MySearchContext* search, const int x, const int y) const
+{
+	Node* node_ptr = search->node(y * width_ + x);
+	return node_ptr ? (node_ptr->state == IN_CLOSEDLIST) : false;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+__forceinline bool MyAStar<Passable, Corner, Heuristic>::can_pass(const int x, const int y) const
+{
+	return ((x >= 0) && (x < width_) && (y >= 0) && (y < height_)) ? can_pass_(x, y) : false;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+void MyAStar<Passable, Corner, Heuristic>::find_can_pass_nodes(const MySearchContext* search, const MyPoint& current, std::vector<MyPoint>* out_lists)
+{
+	const int x = current.x();
+	const int y = current.y();
+
+	// the straight neighbours are looked up once, the corner rule of the diagonals reuses them
+	const bool up = can_pass(x, y - 1);
+	const bool left = can_pass(x - 1, y);
+	const bool right = can_pass(x + 1, y);
+	const bool down = can_pass(x, y + 1);
+
+	auto push = [this, search, out_lists](const bool passable, const int dx, const int dy)
+	{
+		if (passable && ((nullptr == search) || !in_closed_list(search, dx, dy)))
+		{
+			out_lists->push_back(MyPoint{ dx, dy });
+		}
+	};
+
+	// keep the row by row order of the surrounding nodes
+	if constexpr (Corner)
+	{
+		push(up && left && can_pass_(x - 1, y - 1), x - 1, y - 1);
+	}
+	push(up, x, y - 1);
+	if constexpr (Corner)
+	{
+		push(up && right && can_pass_(x + 1, y - 1), x + 1, y - 1);
+	}
+	push(left, x - 1, y);
+	push(right, x + 1, y);
+	if constexpr (Corner)
+	{
+		push(down && left && can_pass_(x - 1, y + 1), x - 1, y + 1);
+	}
+	push(down, x, y + 1);
+	if constexpr (Corner)
+	{
+		push(down && right && can_pass_(x + 1, y + 1), x + 1, y + 1);
+	}
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+void MyAStar<Passable, Corner, Heuristic>::build_path(Node* node, std::vector<MyPoint>* path) const
+{
+	const size_t first = path->size();
+	for (; node->parent; node = node->parent)
+	{
+		path->push_back(node->pos);
+	}
+	std::reverse(path->begin() + first, path->end());
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+void MyAStar<Passable, Corner, Heuristic>::handle_found_node(Node*& current, Node*& destination)
+{
+	int g_value = calcul_g_value(current, destination->pos);
+	if ((g_value) < (destination->g))
+	{
+		destination->g = g_value;
+		destination->parent = current;
+		open_list_.decrease(destination);
+	}
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+void MyAStar<Passable, Corner, Heuristic>::handle_not_found_node(Node*& current, Node*& destination, const MyPoint& end)
+{
+	destination->parent = current;
+	destination->h = calcul_h_value(destination->pos, end);
+	destination->g = calcul_g_value(current, destination->pos);
+
+	destination->state = IN_OPENLIST;
+
+	open_list_.push(destination);
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+bool MyAStar<Passable, Corner, Heuristic>::find(const MyParams& param, std::vector<MyPoint>* path)
+{
+	return SEARCH_FOUND == find(param, MyBudget{}, path);
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+SEARCHSTATUS MyAStar<Passable, Corner, Heuristic>::find(const MyParams& param, const MyBudget& budget, std::vector<MyPoint>* path)
+{
+	if (!begin(param))
+	{
+		return SEARCH_NOPATH;
+	}
+
+	const SEARCHSTATUS status = resume(budget, path);
+	if ((SEARCH_EXPANSIONS == status) || (SEARCH_TIMEOUT == status))
+	{
+		partial_path(path);
+		clear();
+	}
+	return status;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+bool MyAStar<Passable, Corner, Heuristic>::begin(const MyParams& param)
+{
+	if (!is_vlid_params(param))
+	{
+		return false;
+	}
+
+	// initialize
+	init(param);
+	end_ = param.end;
+
+	// put the start node into the open list
+	Node* start_node = context_->create(param.start);
+	start_node->h = calcul_h_value(param.start, param.end);
+	start_node->state = IN_OPENLIST;
+	open_list_.push(start_node);
+
+	closest_ = start_node;
+	return true;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+SEARCHSTATUS MyAStar<Passable, Corner, Heuristic>::resume(const MyBudget& budget, std::vector<MyPoint>* path)
+{
+	std::vector<MyPoint> nearby_nodes;
+	nearby_nodes.reserve(Corner ? 8 : 4);
+
+	// no limit is the same as one that is never reached
+	const int max_expansions = (budget.expansions > 0) ? budget.expansions : INT_MAX;
+	const bool timed = budget.micros > 0;
+	const auto deadline = timed ? (std::chrono::steady_clock::now() + std::chrono::microseconds(budget.micros)) : std::chrono::steady_clock::time_point{};
+	int expansions = 0;
+	SEARCHSTATUS status = SEARCH_NOPATH;
+
+	// searching for the path
+	while (!open_list_.empty())
+	{
+		// stop on the limits before the next node is taken, so a resumed search goes on from it
+		// the clock is only read every few expansions, and not before the first ones so every slice makes progress
+		if (expansions >= max_expansions)
+		{
+			status = SEARCH_EXPANSIONS;
+			break;
+		}
+
+		if (timed && (0 != expansions) && (0 == (expansions & (kClockInterval - 1))) && (std::chrono::steady_clock::now() >= deadline))
+		{
+			status = SEARCH_TIMEOUT;
+			break;
+		}
+
+		// pop the node with the lowest f value
+		Node* current = open_list_.pop();
+		current->state = NodeState::IN_CLOSEDLIST;
+
+		// is the destination found?
+		if ((current->pos) == (end_))
+		{
+			build_path(current, path);
+			clear();
+			return SEARCH_FOUND;
+		}
+
+		if (current->h < closest_->h)
+		{
+			closest_ = current;
+		}
+		++expansions;
+
+		// find the nearby nodes that can be passed
+		nearby_nodes.clear();
+		find_can_pass_nodes(context_, current->pos, &nearby_nodes);
+
+		// calculate the cost value of the nearby nodes
+		size_t index = 0;
+		const size_t size = nearby_nodes.size();
+		while ((index) < (size))
+		{
+			Node* next_node = nullptr;
+			if (in_open_list(nearby_nodes[index], next_node))
+			{
+				handle_found_node(current, next_node);
+			}
+			else
+			{
+				next_node = context_->create(nearby_nodes[index]);
+				handle_not_found_node(current, next_node, end_);
+			}
+			++index;
+		}
+	}
+
+	if (SEARCH_NOPATH == status)
+	{
+		clear();
+	}
+	return status;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+void MyAStar<Passable, Corner, Heuristic>::partial_path(std::vector<MyPoint>* path) const
+{
+	if (nullptr != closest_)
+	{
+		build_path(closest_, path);
+	}
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+bool MyAStar<Passable, Corner, Heuristic>::find_bidirectional(const MyParams& param, MySearchContext* backward, std::vector<MyPoint>* path)
+{
+	if (!is_vlid_params(param) || (nullptr == backward) || (backward == context_))
+	{
+		return false;
+	}
+
+	// initialize
+	init(param);
+	backward->begin(width_, height_);
+
+	// one direction of the search, the backward one runs from the end towards the start
+	// both use the bound as heuristic, the stop test below is only exact with a consistent one
+	struct Side
+	{
+		MySearchContext* context;
+		MyIndexedHeap<Node, MyNodeLess>& open;
+		MyPoint target;
+	};
+	Side forward{ context_, open_list_, param.end };
+	Side reverse{ backward, backward->open_list(), param.start };
+
+	for (Side* side : { &forward, &reverse })
+	{
+		const MyPoint& origin = (side == &forward) ? param.start : param.end;
+		Node* node = side->context->create(origin);
+		node->h = calcul_bound_value(origin, side->target);
+		node->state = IN_OPENLIST;
+		side->open.push(node);
+	}
+
+	// cost of the best path found so far and the cell where its two halves meet
+	int best = INT_MAX;
+	Node* meet_forward = nullptr;
+	Node* meet_reverse = nullptr;
+	if (param.start == param.end)
+	{
+		best = 0;
+		meet_forward = forward.open.top();
+		meet_reverse = reverse.open.top();
+	}
+
+	std::vector<MyPoint> nearby_nodes;
+	nearby_nodes.reserve(Corner ? 8 : 4);
+
+	while (!forward.open.empty() && !reverse.open.empty())
+	{
+		// a shorter path has to leave through an open node of each side, and none of them costs less than its f
+		if ((std::max)(forward.open.top()->f(), reverse.open.top()->f()) >= best)
+		{
+			break;
+		}
+
+		// grow the smaller frontier
+		const bool ahead = forward.open.size() <= reverse.open.size();
+		Side& side = ahead ? forward : reverse;
+		Side& other = ahead ? reverse : forward;
+
+		Node* current = side.open.pop();
+		current->state = NodeState::IN_CLOSEDLIST;
+
+		// the other side closed the cell already, the best path through it was counted when they met
+		const Node* closed = other.context->node(current->pos.y() * width_ + current->pos.x());
+		if ((nullptr != closed) && (NodeState::IN_CLOSEDLIST == closed->state))
+		{
+			continue;
+		}
+
+		nearby_nodes.clear();
+		find_can_pass_nodes(side.context, current->pos, &nearby_nodes);
+		for (const MyPoint& pos : nearby_nodes)
+		{
+			const int index = pos.y() * width_ + pos.x();
+			const int g_value = calcul_g_value(current, pos);
+			Node* next_node = side.context->node(index);
+			if (nullptr == next_node)
+			{
+				// no path through the cell can beat the best one found
+				const int h_value = calcul_bound_value(pos, side.target);
+				if (g_value + h_value >= best)
+				{
+					continue;
+				}
+
+				next_node = side.context->create(pos);
+				next_node->parent = current;
+				next_node->g = g_value;
+				next_node->h = h_value;
+				next_node->state = IN_OPENLIST;
+				side.open.push(next_node);
+			}
+			else if (g_value < next_node->g)
+			{
+				next_node->g = g_value;
+				next_node->parent = current;
+				side.open.decrease(next_node);
+			}
+			else
+			{
+				continue;
+			}
+
+			// the other side reached the cell too, its two halves make a path
+			Node* mirror = other.context->node(index);
+			if ((nullptr != mirror) && (next_node->g + mirror->g < best))
+			{
+				best = next_node->g + mirror->g;
+				meet_forward = ahead ? next_node : mirror;
+				meet_reverse = ahead ? mirror : next_node;
+			}
+		}
+	}
+
+	if (nullptr != meet_forward)
+	{
+		// the forward half leads from the start to the meeting cell, the backward half from there to the end
+		build_path(meet_forward, path);
+
+		for (Node* node = meet_reverse->parent; node; node = node->parent)
+		{
+			path->push_back(node->pos);
+		}
+	}
+
+	clear();
+	reverse.open.clear();
+	return nullptr != meet_forward;
+}
+
+template <typename Passable, bool Corner, typename Heuristic>
+bool MyAStar<Passable, Corner, Heuristic>::find_bounded(const MyParams& param, const MyBound& bound, std::vector<MyPoint>* path, double* ratio)
+{
+	if (!is_vlid_params(param) || !(bound.epsilon >= 0.0) || ((BOUND_WEIGHTED != bound.mode) && (BOUND_FOCAL != bound.mode)))
+	{
+		return false;
+	}
+
+	// initialize
+	init(param);
+
+	const double weight = 1.0 + bound.epsilon;
+	const bool focal = BOUND_FOCAL == bound.mode;
+	MyIndexedHeap<Node, MyFocalLess>& focal_list = context_->focal_list();
+
+	// the focal search keeps the open nodes with f up to the limit in the focal list and the rest in the open list,
+	// and counts the f values of both to know the lowest one
+	std::map<int, int> f_counts;
+	int limit = 0;
+
+	// weighted A* orders by g plus the scaled estimate, the focal search by g plus the estimate
+	auto estimate = [this, &param, focal, weight](const MyPoint& pos)
+	{
+		const int h_value = calcul_bound_value(pos, param.end);
+		return focal ? h_value : static_cast<int>(h_value * weight);
+	};
+
+	auto insert = [this, &focal_list, &f_counts, &limit, focal](Node* node)
+	{
+		if (focal)
+		{
+			++f_counts[node->f()];
+			if (node->f() <= limit)
+			{
+				node->state = IN_FOCALLIST;
+				focal_list.push(node);
+				return;
+			}
+		}
+		node->state = IN_OPENLIST;
+		open_list_.push(node);
+	};
+
+	auto erase = [this, &focal_list, &f_counts, focal](Node* node)
+	{
+		if (focal)
+		{
+			auto it = f_counts.find(node->f());
+			if (0 == --it->second)
+			{
+				f_counts.erase(it);
+			}
+		}
+
+		if (IN_FOCALLIST == node->state)
+		{
+			focal_list.remove(node);
+		}
+		else
+		{
+			open_list_.remove(node);
+		}
+	};
+
+	std::vector<MyPoint> nearby_nodes;
+	nearby_nodes.reserve(Corner ? 8 : 4);
+
+	Node* start_node = context_->create(param.start);
+	start_node->h = estimate(param.start);
+	insert(start_node);
+
+	Node* found = nullptr;
+	int lower = 0;
+
+	// lowest g + h of the closed nodes weighted A* improved without reopening, they take part in the lower bound
+	int inconsistent = INT_MAX;
+	while (focal ? !f_counts.empty() : !open_list_.empty())
+	{
+		Node* current = nullptr;
+		if (focal)
+		{
+			// the lowest f only grows with a consistent estimate, the nodes the raised limit covers join the focal list
+			lower = f_counts.begin()->first;
+			limit = (std::max)(limit, static_cast<int>(lower * weight));
+			while (!open_list_.empty() && (open_list_.top()->f() <= limit))
+			{
+				Node* node = open_list_.pop();
+				node->state = IN_FOCALLIST;
+				focal_list.push(node);
+			}
+
+			current = focal_list.top();
+			erase(current);
+		}
+		else
+		{
+			current = open_list_.pop();
+		}
+		current->state = NodeState::IN_CLOSEDLIST;
+
+		if ((current->pos) == (param.end))
+		{
+			found = current;
+			break;
+		}
+
+		// the focal search reopens closed nodes when a shorter path reaches them, its bound needs some open node
+		// on a shortest path with its shortest g. weighted A* keeps its bound without reopening (as ARA* does),
+		// an improved closed node only takes the new g and parent and counts toward the lower bound
+		nearby_nodes.clear();
+		find_can_pass_nodes(nullptr, current->pos, &nearby_nodes);
+		for (const MyPoint& pos : nearby_nodes)
+		{
+			const int g_value = calcul_g_value(current, pos);
+			Node* next_node = context_->node(pos.y() * width_ + pos.x());
+			if (nullptr == next_node)
+			{
+				next_node = context_->create(pos);
+				next_node->h = estimate(pos);
+			}
+			else if (g_value >= next_node->g)
+			{
+				continue;
+			}
+			else if (IN_CLOSEDLIST != next_node->state)
+			{
+				erase(next_node);
+			}
+			else if (!focal)
+			{
+				next_node->g = g_value;
+				next_node->parent = current;
+				inconsistent = (std::min)(inconsistent, g_value + calcul_bound_value(pos, param.end));
+				continue;
+			}
+
+			next_node->g = g_value;
+			next_node->parent = current;
+			insert(next_node);
+		}
+	}
+
+	if (nullptr != found)
+	{
+		// weighted A* scans the open list for the lowest unscaled g + h, the focal search counted it already
+		if (!focal)
+		{
+			lower = (std::min)(found->g, inconsistent);
+			for (size_t index = 0; index < open_list_.size(); ++index)
+			{
+				const Node* node = open_list_.at(index);
+				lower = (std::min)(lower, node->g + calcul_bound_value(node->pos, param.end));
+			}
+		}
+
+		if (nullptr != ratio)
+		{
+			// the bound itself caps the ratio when the closed nodes weighted A* improved leave a weak lower bound
+			*ratio = (lower > 0) ? (std::min)(weight, static_cast<double>(found->g) / lower) : 1.0;
+		}
+		build_path(found, path);
+	}
+
+	focal_list.clear();
+	clear();
+	return nullptr != found;
+}
+
+template class MyAStar<MyGridPass, true>;
+template class MyAStar<MyGridPass, false>;
+template class MyAStar<MyRectPass, true>;
+template class MyAStar<MyRectPass, false>;
+template class MyAStar<MyCallbackPass, true>;
+template class MyAStar<MyCallbackPass, false>;
+
+// the other heuristic policies over the built-in grid
+template class MyAStar<MyGridPass, true, MyManhattan>;
+template class MyAStar<MyGridPass, true, MyChebyshev>;
+template class MyAStar<MyGridPass, true, MyWeighted<MyOctile>>;
+template class MyAStar<MyGridPass, false, MyWeighted<MyManhattan>>;
+
+bool my_astar_find(MySearchContext* context, const MyParams& param, std::vector<MyPoint>* path)
+{
+	if (nullptr == param.can_pass)
+	{
+		return false;
+	}
+
+	const MyCallbackPass can_pass{ param.can_pass };
+	if (param.corner)
+	{
+		MyAStar<MyCallbackPass, true> astar(context, can_pass);
+		return astar.find(param, path);
+	}
+	else
+	{
+		MyAStar<MyCallbackPass, false> astar(context, can_pass);
+		return astar.find(param, path);
+	}
+}
+
+bool my_astar_find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path)
+{
+	const MyGridPass can_pass{ &map };
+	if (param.corner)
+	{
+		MyAStar<MyGridPass, true> astar(context, can_pass);
+		return astar.find(param, path);
+	}
+	else
+	{
+		MyAStar<MyGridPass, false> astar(context, can_pass);
+		return astar.find(param, path);
+	}
+}
+
+SEARCHSTATUS my_astar_find(MySearchContext* context, const MyMap& map, const MyParams& param, const MyBudget& budget, std::vector<MyPoint>* path)
+{
+	const MyGridPass can_pass{ &map };
+	if (param.corner)
+	{
+		MyAStar<MyGridPass, true> astar(context, can_pass);
+		return astar.find(param, budget, path);
+	}
+	else
+	{
+		MyAStar<MyGridPass, false> astar(context, can_pass);
+		return astar.find(param, budget, path);
+	}
+}
+
+bool my_astar_find_bidirectional(MySearchContext* forward, MySearchContext* backward, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path)
+{
+	const MyGridPass can_pass{ &map };
+	if (param.corner)
+	{
+		MyAStar<MyGridPass, true> astar(forward, can_pass);
+		return astar.find_bidirectional(param, backward, path);
+	}
+	else
+	{
+		MyAStar<MyGridPass, false> astar(forward, can_pass);
+		return astar.find_bidirectional(param, backward, path);
+	}
+}
+
+bool my_astar_find_bounded(MySearchContext* context, const MyMap& map, const MyParams& param, const MyBound& bound, std::vector<MyPoint>* path, double* ratio)
+{
+	const MyGridPass can_pass{ &map };
+	if (param.corner)
+	{
+		MyAStar<MyGridPass, true> astar(context, can_pass);
+		return astar.find_bounded(param, bound, path, ratio);
+	}
+	else
+	{
+		MyAStar<MyGridPass, false> astar(context, can_pass);
+		return astar.find_bounded(param, bound, path, ratio);
+	}
 }
\ No newline at end of file
@@ -1,80 +1,207 @@
-﻿#pragma once
-#ifndef MYASTAR_H
-#define MYASTAR_H
-#pragma execution_character_set("utf-8")
-#include "mydraw.hpp"
-
-class BlockAllocator;
-
-class MyAStar
-{
-public:
-
-public:
-	explicit MyAStar(BlockAllocator* allocator);
-
-	virtual ~MyAStar();
-
-	// get the straight-line heuristic value
-	MY_REQUIRED_RESULT constexpr int get_step_value() const;
-
-	// get the corner-turn heuristic value
-	MY_REQUIRED_RESULT constexpr int get_oblique_value() const;
-
-	// execute the pathfinding operation
-	MY_REQUIRED_RESULT bool __vectorcall find(const MyParams& param, std::vector<MyPoint>* path);
-
-private:
-	int                step_val_ = 10;
-	int                oblique_val_ = 14;
-	std::vector<Node*> mapping_;
-	int                height_ = 0;
-	int                width_ = 0;
-	Callback           can_pass_ = nullptr;
-	std::vector<Node*> open_list_;
-	BlockAllocator* allocator_ = nullptr;
-
-	// free data and unuse memory
-	void clear();
-
-	// initial data
-	void __vectorcall init(const MyParams& param);
-
-	// check a import parmas is valid or not
-	MY_REQUIRED_RESULT const bool __vectorcall is_vlid_params(const MyParams& param) const;
-
-	// binary heap filter
-	constexpr void __vectorcall percolate_up(int hole);
-
-	// get the index of the node
-	MY_REQUIRED_RESULT const bool __vectorcall get_node_index(Node*& node, int* index) const;
-
-	// calculate the cost of the node
-	MY_REQUIRED_RESULT __forceinline const int __vectorcall calcul_g_value(Node* parent, const MyPoint& current) const;
-
-	// calculate the heuristic value of the node
-	MY_REQUIRED_RESULT __forceinline const int __vectorcall calcul_h_value(const MyPoint& current, const MyPoint& end) const;
-
-	// check the point is in the open list or not, get node if it is
-	MY_REQUIRED_RESULT __forceinline constexpr bool __vectorcall in_open_list(const MyPoint& pos, Node*& out_node)  const;
-
-	// check the point is in the close list or not
-	MY_REQUIRED_RESULT __forceinline constexpr bool __vectorcall in_closed_list(const MyPoint& pos) const;
-
-	// check the point is passable
-	MY_REQUIRED_RESULT bool __vectorcall can_pass(const MyPoint& pos);
-
-	// check the point is passable and enable to reach the destination
-	MY_REQUIRED_RESULT bool __vectorcall can_pass(const MyPoint& current, const MyPoint& destination, const bool allow_corner);
-
-	// get the surrounding 4 or 8 nodes that can pass
-	void __vectorcall find_can_pass_nodes(const MyPoint& current, const bool allow_corner, std::vector<MyPoint>* out_lists);
-
-	// process the situation of finding the node
-	void __vectorcall handle_found_node(Node*& current, Node*& destination);
-
-	// process the situation of not finding the node
-	void __vectorcall handle_not_found_node(Node*& current, Node*& destination, const MyPoint& end);
-};
-
-#endif
+﻿#pragma once
+#ifndef MYASTAR_H
+#define MYASTAR_H
+#pragma execution_character_set("utf-8")
+#include "mydraw.hpp"
+#include "mymap.h"
+#include "mycontext.h"
+
+// passability policy for the built-in grid maps, fully inlined into the search
+struct MyGridPass
+{
+	const MyMap* map = nullptr;
+
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall operator()(const int x, const int y) const
+	{
+		return map->is_road(x, y);
+	}
+};
+
+// passability policy for a rectangle of a built-in grid map, cells outside it are walls
+struct MyRectPass
+{
+	const MyMap* map = nullptr;
+	int left = 0;
+	int top = 0;
+	int right = 0;                          // exclusive
+	int bottom = 0;                         // exclusive
+
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall operator()(const int x, const int y) const
+	{
+		return (x >= left) && (x < right) && (y >= top) && (y < bottom) && map->is_road(x, y);
+	}
+};
+
+// passability policy for custom std::function callbacks
+struct MyCallbackPass
+{
+	Callback fn = nullptr;
+
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall operator()(const int x, const int y) const
+	{
+		return fn(MyPoint{ x, y });
+	}
+};
+
+// heuristic policies, the estimated cost between cells dx columns and dy rows apart (dx, dy >= 0)
+// in the units of the step and oblique costs of the search
+struct MyOctile
+{
+	// exact on an open 8-dir grid, never overestimates
+	MY_REQUIRED_RESULT __forceinline int __vectorcall operator()(const int dx, const int dy, const int step, const int oblique) const
+	{
+		return (std::max)(dx, dy) * step + (std::min)(dx, dy) * (oblique - step);
+	}
+};
+
+struct MyManhattan
+{
+	// exact on an open 4-dir grid, overestimates the diagonal moves of an 8-dir grid
+	MY_REQUIRED_RESULT __forceinline int __vectorcall operator()(const int dx, const int dy, const int step, const int) const
+	{
+		return (dx + dy) * step;
+	}
+};
+
+struct MyChebyshev
+{
+	// the longer axis only, never overestimates but is looser than octile
+	MY_REQUIRED_RESULT __forceinline int __vectorcall operator()(const int dx, const int dy, const int step, const int) const
+	{
+		return (std::max)(dx, dy) * step;
+	}
+};
+
+// the base heuristic scaled by percent / 100, a higher weight expands fewer nodes for a longer path
+// with a base that never overestimates the path costs at most percent / 100 times the shortest one
+template <typename Base>
+struct MyWeighted
+{
+	Base base = {};
+	int percent = 100;
+
+	MY_REQUIRED_RESULT __forceinline int __vectorcall operator()(const int dx, const int dy, const int step, const int oblique) const
+	{
+		return base(dx, dy, step, oblique) * percent / 100;
+	}
+};
+
+// the tightest heuristic that never overestimates for the connectivity
+template <bool Corner>
+using MyBestHeuristic = std::conditional_t<Corner, MyOctile, MyManhattan>;
+
+// Passable: passability policy, called with points inside the map only
+// Corner: 8-dir if true otherwise 4-dir, must match MyParams::corner
+// Heuristic: heuristic policy, picked at compile time so the estimate is inlined into the search
+template <typename Passable, bool Corner, typename Heuristic = MyBestHeuristic<Corner>>
+class MyAStar
+{
+public:
+
+public:
+	explicit MyAStar(MySearchContext* context, const Passable& can_pass, const Heuristic& heuristic = Heuristic{});
+
+	virtual ~MyAStar();
+
+	// get the straight-line heuristic value
+	MY_REQUIRED_RESULT constexpr int get_step_value() const;
+
+	// get the corner-turn heuristic value
+	MY_REQUIRED_RESULT constexpr int get_oblique_value() const;
+
+	// execute the pathfinding operation
+	MY_REQUIRED_RESULT bool __vectorcall find(const MyParams& param, std::vector<MyPoint>* path);
+
+	// execute the pathfinding operation within the limits of the budget
+	// when a limit stops it the path leads to the expanded node with the lowest h
+	MY_REQUIRED_RESULT SEARCHSTATUS __vectorcall find(const MyParams& param, const MyBudget& budget, std::vector<MyPoint>* path);
+
+	// set up a search that runs in slices, false if the params are invalid
+	MY_REQUIRED_RESULT bool __vectorcall begin(const MyParams& param);
+
+	// run the search set up by begin until it ends or a limit of the budget is hit
+	// SEARCH_EXPANSIONS and SEARCH_TIMEOUT mean the slice is used up and resume can be called again,
+	// the search is over after SEARCH_FOUND, which appends the path, or SEARCH_NOPATH
+	MY_REQUIRED_RESULT SEARCHSTATUS __vectorcall resume(const MyBudget& budget, std::vector<MyPoint>* path);
+
+	// append the path to the expanded node with the lowest h so far
+	void __vectorcall partial_path(std::vector<MyPoint>* path) const;
+
+	// search from the start and from the end at once and join the two halves where they meet
+	// stops once no path through the open lists can beat the best meeting, so the path is a shortest one
+	// backward keeps the nodes of the search from the end and must not be the context of this search
+	MY_REQUIRED_RESULT bool __vectorcall find_bidirectional(const MyParams& param, MySearchContext* backward, std::vector<MyPoint>* path);
+
+	// bounded-suboptimal search, the path costs at most (1 + bound.epsilon) times the shortest one
+	// ratio receives the cost of the path over a lower bound of the shortest one, so the real ratio is at most that
+	// the estimate is always the octile or Manhattan bound, a heuristic policy that overestimates would break the guarantee
+	MY_REQUIRED_RESULT bool __vectorcall find_bounded(const MyParams& param, const MyBound& bound, std::vector<MyPoint>* path, double* ratio);
+
+private:
+	int                step_val_ = 10;
+	int                oblique_val_ = 14;
+	int                height_ = 0;
+	int                width_ = 0;
+	Passable           can_pass_ = {};
+	Heuristic          heuristic_ = {};
+	MySearchContext* context_ = nullptr;
+	MyIndexedHeap<Node, MyNodeLess>& open_list_;
+	MyPoint            end_ = {};
+	Node*              closest_ = nullptr;     // the expanded node closest to the end, where a stopped search leads
+
+	// forget the current search, the nodes stay in the context until its next begin
+	void clear();
+
+	// initial data
+	void __vectorcall init(const MyParams& param);
+
+	// check a import parmas is valid or not
+	MY_REQUIRED_RESULT const bool __vectorcall is_vlid_params(const MyParams& param) const;
+
+	// calculate the cost of the node
+	MY_REQUIRED_RESULT __forceinline const int __vectorcall calcul_g_value(Node* parent, const MyPoint& current) const;
+
+	// calculate the heuristic value of the node with the heuristic policy
+	MY_REQUIRED_RESULT __forceinline const int __vectorcall calcul_h_value(const MyPoint& current, const MyPoint& end) const;
+
+	// lower bound of the cost between the points, octile for 8-dir and Manhattan for 4-dir
+	MY_REQUIRED_RESULT __forceinline const int __vectorcall calcul_bound_value(const MyPoint& current, const MyPoint& end) const;
+
+	// check the point is in the open list or not, get node if it is
+	MY_REQUIRED_RESULT __forceinline constexpr bool __vectorcall in_open_list(const MyPoint& pos, Node*& out_node)  const;
+
+	// check the point is in the close list of the search or not
+	MY_REQUIRED_RESULT __forceinline constexpr bool __vectorcall in_closed_list(const MySearchContext* search, const int x, const int y) const;
+
+	// check the point is inside the map and passable
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall can_pass(const int x, const int y) const;
+
+	// get the surrounding 4 or 8 nodes that can pass and are not closed in the search, all of them if search is nullptr
+	void __vectorcall find_can_pass_nodes(const MySearchContext* search, const MyPoint& current, std::vector<MyPoint>* out_lists);
+
+	// append the path from the start to the node, the start is not included
+	void __vectorcall build_path(Node* node, std::vector<MyPoint>* path) const;
+
+	// process the situation of finding the node
+	void __vectorcall handle_found_node(Node*& current, Node*& destination);
+
+	// process the situation of not finding the node
+	void __vectorcall handle_not_found_node(Node*& current, Node*& destination, const MyPoint& end);
+};
+
+// run the search with the std::function callback of the params, connectivity is taken from param.corner
+MY_REQUIRED_RESULT bool __vectorcall my_astar_find(MySearchContext* context, const MyParams& param, std::vector<MyPoint>* path);
+
+// run the fully inlined search over a built-in grid map, connectivity is taken from param.corner
+MY_REQUIRED_RESULT bool __vectorcall my_astar_find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path);
+
+// run the fully inlined search over a built-in grid map within the limits of the budget
+MY_REQUIRED_RESULT SEARCHSTATUS __vectorcall my_astar_find(MySearchContext* context, const MyMap& map, const MyParams& param, const MyBudget& budget, std::vector<MyPoint>* path);
+
+// run the bidirectional search over a built-in grid map, the two contexts must differ
+MY_REQUIRED_RESULT bool __vectorcall my_astar_find_bidirectional(MySearchContext* forward, MySearchContext* backward, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path);
+
+// run the bounded-suboptimal search over a built-in grid map
+MY_REQUIRED_RESULT bool __vectorcall my_astar_find_bounded(MySearchContext* context, const MyMap& map, const MyParams& param, const MyBound& bound, std::vector<MyPoint>* path, double* ratio);
+
+#endif
@@ -0,0 +1,266 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mybitmap.h"
+
+// compression of the plain rgb rows and of rows described by channel masks
+constexpr uint32_t kBiRgb = 0;
+constexpr uint32_t kBiBitFields = 3;
+
+// bytes read at once, narrow images would otherwise need one read per row
+constexpr size_t kBlockBytes = 1 << 20;
+
+// header fields are little-endian and not aligned
+template <typename T>
+static __forceinline T read_le(const char* field)
+{
+	T value = 0;
+	memcpy(&value, field, sizeof(T));
+	return value;
+}
+
+static __forceinline bool is_wall(const uint8_t* bgr, const MyRGB& wall)
+{
+	return (bgr[0] == wall.b) && (bgr[1] == wall.g) && (bgr[2] == wall.r);
+}
+
+bool MyBitmapReader::open(const std::wstring& fileName)
+{
+	file_.open(fileName, std::ios::in | std::ios::binary);
+	if (!file_.is_open())
+		return false;
+
+	BitMapFileHeader file_header = {};
+	BitmapInfoHeader info_header = {};
+	if (!file_.read(reinterpret_cast<char*>(&file_header), sizeof(file_header))
+		|| !file_.read(reinterpret_cast<char*>(&info_header), sizeof(info_header)))
+		return false;
+
+	const uint32_t info_size = read_le<uint32_t>(info_header.biSize);
+	const int32_t width = read_le<int32_t>(info_header.biWidth);
+	const int32_t height = read_le<int32_t>(info_header.biHeight);
+	const uint32_t compression = read_le<uint32_t>(info_header.biCompression);
+	bits_ = read_le<uint16_t>(info_header.biBitCount);
+	offset_ = read_le<uint32_t>(file_header.bfOffBits);
+
+	// BITMAPINFOHEADER or one of its later versions, the 12-byte core header is not supported
+	if ((file_header.bfType[0] != 'B') || (file_header.bfType[1] != 'M')
+		|| (info_size < sizeof(BitmapInfoHeader))
+		|| (1 != read_le<uint16_t>(info_header.biPlanes))
+		|| (width <= 0) || (0 == height) || (INT_MIN == height))
+		return false;
+
+	if ((1 != bits_) && (4 != bits_) && (8 != bits_) && (24 != bits_) && (32 != bits_))
+		return false;
+
+	if (kBiBitFields == compression)
+	{
+		// the masks follow the first 40 bytes in every header version, only the plain BGRX layout is read
+		char masks[12] = {};
+		if ((32 != bits_) || !file_.read(masks, sizeof(masks))
+			|| (0x00ff0000u != read_le<uint32_t>(masks))
+			|| (0x0000ff00u != read_le<uint32_t>(masks + 4))
+			|| (0x000000ffu != read_le<uint32_t>(masks + 8)))
+			return false;
+	}
+	else if (kBiRgb != compression)
+	{
+		return false;
+	}
+
+	const uint32_t palette_offset = static_cast<uint32_t>(sizeof(BitMapFileHeader)) + info_size;
+	if (offset_ < palette_offset)
+		return false;
+
+	if (bits_ <= 8)
+	{
+		// biClrUsed of 0 means a full palette
+		const uint32_t used = read_le<uint32_t>(info_header.biClrUsed);
+		const uint32_t count = ((0 == used) || (used > (1u << bits_))) ? (1u << bits_) : used;
+		if ((offset_ - palette_offset) / 4 < count)
+			return false;
+
+		std::vector<uint8_t> quads(static_cast<size_t>(count) * 4);
+		file_.seekg(palette_offset, std::ios::beg);
+		if (!file_.read(reinterpret_cast<char*>(quads.data()), quads.size()))
+			return false;
+
+		palette_.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+			palette_[i] = MyRGB{ quads[i * 4 + 2], quads[i * 4 + 1], quads[i * 4] };
+	}
+
+	width_ = width;
+	height_ = (height < 0) ? -height : height;
+	top_down_ = height < 0;
+	pitch_ = ((static_cast<size_t>(width_) * bits_ + 31) / 32) * 4;
+	return true;
+}
+
+bool MyBitmapReader::read(MyMapEditor* editor, const MyRGB& wall)
+{
+	if (!file_.is_open() || (editor->map().width != width_) || (editor->map().height != height_))
+		return false;
+
+	// road bits of every byte value of the indexed formats, the first pixel of the byte is in its high bits
+	uint8_t table[256] = {};
+	if (bits_ <= 8)
+	{
+		const int per_byte = 8 / bits_;
+		const size_t mask = (static_cast<size_t>(1) << bits_) - 1;
+		for (int value = 0; value < 256; ++value)
+		{
+			for (int i = 0; i < per_byte; ++i)
+			{
+				const size_t index = (static_cast<size_t>(value) >> (8 - (i + 1) * bits_)) & mask;
+				if ((index >= palette_.size()) || !(palette_[index] == wall))
+					table[value] |= static_cast<uint8_t>(1u << i);
+			}
+		}
+	}
+
+	const size_t rows_per_block = (std::max)(static_cast<size_t>(1), kBlockBytes / pitch_);
+	buffer_.resize((std::min)(rows_per_block, static_cast<size_t>(height_)) * pitch_);
+
+	file_.clear();
+	file_.seekg(offset_, std::ios::beg);
+	int stored = 0;
+	while (stored < height_)
+	{
+		const size_t rows = (std::min)(rows_per_block, static_cast<size_t>(height_ - stored));
+		if (!file_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(rows * pitch_)))
+			return false;
+
+		for (size_t i = 0; i < rows; ++i, ++stored)
+		{
+			const uint8_t* pixels = buffer_.data() + i * pitch_;
+			uint64_t* out = editor->mutable_row(top_down_ ? stored : (height_ - 1 - stored));
+			if (24 == bits_)
+				classify_rgb(pixels, wall, out);
+			else if (32 == bits_)
+				classify_rgba(pixels, wall, out);
+			else
+				classify_indexed(pixels, table, out);
+		}
+	}
+	return true;
+}
+
+void MyBitmapReader::classify_indexed(const uint8_t* pixels, const uint8_t* table, uint64_t* out) const
+{
+	// a byte holds a whole number of pixels and a word holds a whole number of bytes
+	const int per_byte = 8 / bits_;
+	const int bytes = (width_ + per_byte - 1) / per_byte;
+	uint64_t word = 0;
+	int shift = 0;
+	int index = 0;
+	for (int i = 0; i < bytes; ++i)
+	{
+		word |= static_cast<uint64_t>(table[pixels[i]]) << shift;
+		shift += per_byte;
+		if (64 == shift)
+		{
+			out[index++] = word;
+			word = 0;
+			shift = 0;
+		}
+	}
+
+	if (0 != shift)
+		out[index] = word;
+
+	// the pixels of the last byte past the width land on the padding bits, which must stay 0
+	if (0 != (width_ & 63))
+		out[width_ >> 6] &= (1ULL << (width_ & 63)) - 1;
+}
+
+void MyBitmapReader::classify_rgb(const uint8_t* pixels, const MyRGB& wall, uint64_t* out) const
+{
+	// 16 pixels are 48 bytes, three vectors against the wall colour repeated in BGR order
+	alignas(16) uint8_t pattern[48] = {};
+	for (int i = 0; i < 48; i += 3)
+	{
+		pattern[i] = wall.b;
+		pattern[i + 1] = wall.g;
+		pattern[i + 2] = wall.r;
+	}
+
+	const __m128i key0 = _mm_load_si128(reinterpret_cast<const __m128i*>(pattern));
+	const __m128i key1 = _mm_load_si128(reinterpret_cast<const __m128i*>(pattern + 16));
+	const __m128i key2 = _mm_load_si128(reinterpret_cast<const __m128i*>(pattern + 32));
+
+	int x = 0;
+	for (; x + 64 <= width_; x += 64)
+	{
+		uint64_t walls = 0;
+		for (int group = 0; group < 4; ++group)
+		{
+			const __m128i* p = reinterpret_cast<const __m128i*>(pixels + static_cast<size_t>(x + group * 16) * 3);
+			const uint64_t same = static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p), key0)))
+				| (static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 1), key1))) << 16)
+				| (static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 2), key2))) << 32);
+
+			// a pixel is a wall when its three bytes match, bit 3 * i then holds the answer for pixel i
+			const uint64_t all = same & (same >> 1) & (same >> 2);
+			for (int i = 0; i < 16; ++i)
+				walls |= ((all >> (i * 3)) & 1ULL) << (group * 16 + i);
+		}
+		*out++ = ~walls;
+	}
+
+	if (x < width_)
+	{
+		uint64_t road = 0;
+		for (int i = x; i < width_; ++i)
+		{
+			if (!is_wall(pixels + static_cast<size_t>(i) * 3, wall))
+				road |= 1ULL << (i - x);
+		}
+		*out = road;
+	}
+}
+
+void MyBitmapReader::classify_rgba(const uint8_t* pixels, const MyRGB& wall, uint64_t* out) const
+{
+	// the fourth byte is alpha or unused and does not take part in the compare
+	const __m128i key = _mm_set1_epi32(static_cast<int>(wall.b | (wall.g << 8) | (wall.r << 16)));
+	const __m128i colour = _mm_set1_epi32(0x00ffffff);
+
+	int x = 0;
+	for (; x + 64 <= width_; x += 64)
+	{
+		uint64_t walls = 0;
+		const __m128i* p = reinterpret_cast<const __m128i*>(pixels + static_cast<size_t>(x) * 4);
+		for (int i = 0; i < 16; ++i)
+		{
+			const __m128i same = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(p + i), colour), key);
+			walls |= static_cast<uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(same))) << (i * 4);
+		}
+		*out++ = ~walls;
+	}
+
+	if (x < width_)
+	{
+		uint64_t road = 0;
+		for (int i = x; i < width_; ++i)
+		{
+			if (!is_wall(pixels + static_cast<size_t>(i) * 4, wall))
+				road |= 1ULL << (i - x);
+		}
+		*out = road;
+	}
+}
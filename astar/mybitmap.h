@@ -0,0 +1,64 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYBITMAP_H
+#define MYBITMAP_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+
+// streaming reader of uncompressed BMP images
+// supports 1, 4, 8, 24 and 32 bits per pixel, bottom-up and top-down rows and any header version,
+// the rows are read in file order into one reused buffer and classified straight into the map rows
+class MyBitmapReader
+{
+	MY_DISABLE_COPY_MOVE(MyBitmapReader)
+public:
+	explicit MyBitmapReader() = default;
+
+	virtual ~MyBitmapReader() = default;
+
+	// open the file and parse the headers, return false if the file is not a supported BMP
+	MY_REQUIRED_RESULT bool __vectorcall open(const std::wstring& fileName);
+
+	MY_REQUIRED_RESULT int width() const { return width_; }
+
+	MY_REQUIRED_RESULT int height() const { return height_; }
+
+	// read the pixels into an editor of width() x height(), row y of the picture becomes row y of the map
+	// pixels of the wall colour become collisions and every other pixel becomes road
+	// return false if the file ends before the last row
+	MY_REQUIRED_RESULT bool __vectorcall read(MyMapEditor* editor, const MyRGB& wall);
+
+private:
+	void __vectorcall classify_indexed(const uint8_t* pixels, const uint8_t* table, uint64_t* out) const;
+	void __vectorcall classify_rgb(const uint8_t* pixels, const MyRGB& wall, uint64_t* out) const;
+	void __vectorcall classify_rgba(const uint8_t* pixels, const MyRGB& wall, uint64_t* out) const;
+
+private:
+	std::ifstream file_;
+	int width_ = 0;
+	int height_ = 0;
+	int bits_ = 0;                          // bits per pixel
+	bool top_down_ = false;                 // rows are stored from the top instead of the bottom
+	uint32_t offset_ = 0;                   // bfOffBits, start of the pixel rows
+	size_t pitch_ = 0;                      // bytes per stored row, padded to 4 bytes
+	std::vector<MyRGB> palette_;            // colours of the indexed formats
+	std::vector<uint8_t> buffer_;           // reused block of stored rows
+};
+
+#endif
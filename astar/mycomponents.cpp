@@ -0,0 +1,319 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mycomponents.h"
+
+std::shared_ptr<const MyComponents> MyComponents::build(const MyMap& map)
+{
+	std::shared_ptr<MyComponents> labels = std::make_shared<MyComponents>();
+	labels->width_ = map.width;
+	labels->height_ = map.height;
+	labels->chunk_shift_ = map.chunk_shift;
+
+	const size_t words = static_cast<size_t>(map.width) << map.chunk_shift;
+	std::vector<uint32_t*> rows(map.height, nullptr);
+	labels->chunks_.reserve(map.chunks.size());
+	for (size_t i = 0; i < map.chunks.size(); ++i)
+	{
+		std::shared_ptr<uint32_t[]> chunk = std::make_shared<uint32_t[]>(words);
+		const int first = static_cast<int>(i << map.chunk_shift);
+		const int last = (std::min)(first + (1 << map.chunk_shift), map.height);
+		for (int y = first; y < last; ++y)
+			rows[y] = chunk.get() + static_cast<size_t>(y - first) * map.width;
+		labels->chunks_.push_back(std::move(chunk));
+	}
+
+	// flood every unlabelled passable cell with a fresh label
+	std::vector<MyPoint> queue;
+	int x = 0;
+	for (int y = 0; y < map.height; ++y)
+	{
+		for (x = 0; x < map.width; ++x)
+		{
+			if ((rows[y][x] != 0) || !map.is_road(x, y))
+				continue;
+
+			const uint32_t label = labels->next_++;
+			rows[y][x] = label;
+			queue.assign(1, MyPoint{ x, y });
+			while (!queue.empty())
+			{
+				const MyPoint pos = queue.back();
+				queue.pop_back();
+
+				auto visit = [&map, &rows, &queue, label](const int nx, const int ny)
+				{
+					if (map.contains(nx, ny) && (rows[ny][nx] == 0) && map.is_road(nx, ny))
+					{
+						rows[ny][nx] = label;
+						queue.push_back(MyPoint{ nx, ny });
+					}
+				};
+
+				visit(pos.x(), pos.y() - 1);
+				visit(pos.x() - 1, pos.y());
+				visit(pos.x() + 1, pos.y());
+				visit(pos.x(), pos.y() + 1);
+			}
+		}
+	}
+
+	return labels;
+}
+
+bool MyComponents::reachable(const MyMap& map, const MyPoint& a, const MyPoint& b)
+{
+	if (!map.is_road(a.x(), a.y()) || !map.is_road(b.x(), b.y()))
+		return false;
+
+	if (a == b)
+		return true;
+
+	// one bit per cell, the same 4-neighbour steps as build()
+	const int width = map.width;
+	std::vector<uint64_t> seen(((static_cast<size_t>(width) * map.height) + 63) >> 6, 0);
+	auto mark = [&seen](const size_t cell)
+	{
+		uint64_t& word = seen[cell >> 6];
+		const uint64_t bit = 1ull << (cell & 63);
+		if (word & bit)
+			return false;
+		word |= bit;
+		return true;
+	};
+
+	std::vector<MyPoint> queue{ a };
+	std::ignore = mark(static_cast<size_t>(a.y()) * width + a.x());
+	while (!queue.empty())
+	{
+		const MyPoint pos = queue.back();
+		queue.pop_back();
+
+		bool found = false;
+		auto visit = [&](const int nx, const int ny)
+		{
+			if (!map.contains(nx, ny) || !map.is_road(nx, ny) || !mark(static_cast<size_t>(ny) * width + nx))
+				return;
+
+			found = found || ((nx == b.x()) && (ny == b.y()));
+			queue.push_back(MyPoint{ nx, ny });
+		};
+
+		visit(pos.x(), pos.y() - 1);
+		visit(pos.x() - 1, pos.y());
+		visit(pos.x() + 1, pos.y());
+		visit(pos.x(), pos.y() + 1);
+		if (found)
+			return true;
+	}
+
+	return false;
+}
+
+std::shared_ptr<const MyComponents> MyComponents::update(const MyComponents& base, const MyMap& map, const MyPoint& pos)
+{
+	if ((map.width != base.width_) || (map.height != base.height_) || (map.chunk_shift != base.chunk_shift_))
+		return build(map);
+
+	std::shared_ptr<MyComponents> labels = std::make_shared<MyComponents>();
+	labels->width_ = base.width_;
+	labels->height_ = base.height_;
+	labels->chunk_shift_ = base.chunk_shift_;
+	labels->next_ = base.next_;
+	labels->chunks_ = base.chunks_;
+	labels->writable_.assign(base.chunks_.size(), nullptr);
+
+	const int width = map.width;
+	const int cell = pos.y() * width + pos.x();
+	const bool road = map.is_road(pos.x(), pos.y());
+
+	// one search per passable neighbour, the edited cell itself is left out
+	struct Search
+	{
+		std::vector<int> cells;             // every cell reached, the ones from head on are still to expand
+		size_t head = 0;
+		int group = 0;                      // searches that met share the lowest index among them
+	};
+
+	std::vector<Search> searches;
+	auto seed = [&map, &searches, width](const int x, const int y)
+	{
+		if (map.contains(x, y) && map.is_road(x, y))
+		{
+			Search& search = searches.emplace_back();
+			search.cells.push_back(y * width + x);
+			search.group = static_cast<int>(searches.size()) - 1;
+		}
+	};
+	seed(pos.x(), pos.y() - 1);
+	seed(pos.x() - 1, pos.y());
+	seed(pos.x() + 1, pos.y());
+	seed(pos.x(), pos.y() + 1);
+
+	auto group_of = [&searches](int i)
+	{
+		while (searches[i].group != i)
+			i = searches[i].group;
+		return i;
+	};
+
+	// grow all searches one cell at a time, until they have all met or at most one group can still grow
+	// the groups that stopped are whole regions, so only cells of the smaller regions are ever visited
+	// which search reached a cell first, (generation << 2) | search, reset by bumping the generation
+	thread_local std::vector<uint32_t> marks;
+	thread_local uint32_t generation = 0;
+	const size_t cells = static_cast<size_t>(map.width) * map.height;
+	if ((marks.size() != cells) || (++generation >= (1u << 30)))
+	{
+		marks.assign(cells, 0);
+		generation = 1;
+	}
+
+	for (int i = 0; i < static_cast<int>(searches.size()); ++i)
+		marks[searches[i].cells.front()] = (generation << 2) | i;
+
+	const int count = static_cast<int>(searches.size());
+	std::vector<uint8_t> open(count, 0);
+	for (;;)
+	{
+		std::ranges::fill(open, 0);
+		int groups = 0;
+		int growing = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			const int g = group_of(i);
+			if (g == i)
+				++groups;
+			if (searches[i].head < searches[i].cells.size())
+				open[g] = 1;
+		}
+		for (int i = 0; i < count; ++i)
+			growing += open[i];
+
+		if ((groups <= 1) || (growing <= 1))
+			break;
+
+		for (int i = 0; i < count; ++i)
+		{
+			Search& search = searches[i];
+			if (search.head >= search.cells.size())
+				continue;
+
+			const int current = search.cells[search.head++];
+			const int cx = current % width;
+			const int cy = current / width;
+			auto visit = [&](const int nx, const int ny)
+			{
+				if (!map.contains(nx, ny) || !map.is_road(nx, ny))
+					return;
+
+				const int next = ny * width + nx;
+				if (next == cell)
+					return;
+
+				uint32_t& mark = marks[next];
+				if ((mark >> 2) != generation)
+				{
+					mark = (generation << 2) | i;
+					searches[i].cells.push_back(next);
+					return;
+				}
+
+				const int a = group_of(i);
+				const int b = group_of(static_cast<int>(mark & 3));
+				if (a != b)
+					searches[(std::max)(a, b)].group = (std::min)(a, b);
+			};
+
+			visit(cx, cy - 1);
+			visit(cx - 1, cy);
+			visit(cx + 1, cy);
+			visit(cx, cy + 1);
+		}
+	}
+
+	// the group still growing keeps its label, or the largest one if every group stopped
+	int keep = -1;
+	for (int i = 0; (i < count) && (keep < 0); ++i)
+	{
+		if (searches[i].head < searches[i].cells.size())
+			keep = group_of(i);
+	}
+	if (keep < 0)
+	{
+		std::vector<size_t> sizes(count, 0);
+		for (int i = 0; i < count; ++i)
+			sizes[group_of(i)] += searches[i].cells.size();
+		for (int i = 0; i < count; ++i)
+		{
+			if ((keep < 0) || (sizes[i] > sizes[keep]))
+				keep = i;
+		}
+	}
+
+	auto relabel = [&labels, &searches, &group_of, width, count](const int g, const uint32_t label)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			if (group_of(i) != g)
+				continue;
+			for (const int c : searches[i].cells)
+				labels->mutable_at(c % width, c / width) = label;
+		}
+	};
+
+	if (road)
+	{
+		// the new road joins every region around it, they all take the label of the kept one
+		const uint32_t label = (keep < 0) ? labels->next_++ : labels->at(searches[keep].cells.front() % width, searches[keep].cells.front() / width);
+		for (int i = 0; i < count; ++i)
+		{
+			if ((group_of(i) == i) && (i != keep))
+				relabel(i, label);
+		}
+		labels->mutable_at(pos.x(), pos.y()) = label;
+	}
+	else
+	{
+		// the new wall may cut its region, every part apart from the kept one gets a fresh label
+		for (int i = 0; i < count; ++i)
+		{
+			if ((group_of(i) == i) && (i != keep))
+				relabel(i, labels->next_++);
+		}
+		labels->mutable_at(pos.x(), pos.y()) = 0;
+	}
+
+	labels->writable_.clear();
+	labels->writable_.shrink_to_fit();
+	return labels;
+}
+
+uint32_t& MyComponents::mutable_at(const int x, const int y)
+{
+	const size_t index = static_cast<size_t>(y >> chunk_shift_);
+	uint32_t*& chunk = writable_[index];
+	if (nullptr == chunk)
+	{
+		const size_t words = static_cast<size_t>(width_) << chunk_shift_;
+		std::shared_ptr<uint32_t[]> copy(new uint32_t[words]);
+		memcpy(copy.get(), chunks_[index].get(), words * sizeof(uint32_t));
+		chunk = copy.get();
+		chunks_[index] = std::move(copy);
+	}
+	return chunk[static_cast<size_t>(y & ((1 << chunk_shift_) - 1)) * width_ + x];
+}
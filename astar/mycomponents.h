@@ -0,0 +1,81 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYCOMPONENTS_H
+#define MYCOMPONENTS_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+
+// connected-component labels of a map, one label per passable cell and 0 for collisions
+// a diagonal step needs both straight neighbours passable, so 8-dir and 4-dir connectivity
+// produce the same components and one index serves both corner settings
+// the labels are chunked like the map cells and an edit copies only the chunks it relabels
+class MyComponents
+{
+	MY_DISABLE_COPY_MOVE(MyComponents)
+public:
+	using Chunk = std::shared_ptr<const uint32_t[]>;
+
+	explicit MyComponents() = default;
+
+	virtual ~MyComponents() = default;
+
+	// label every cell of the map
+	MY_REQUIRED_RESULT static std::shared_ptr<const MyComponents> __vectorcall build(const MyMap& map);
+
+	// the labels of an edited map from the labels of the previous version, only the cell at pos changed
+	// the work is bounded by the smaller regions around the cell instead of the whole map
+	MY_REQUIRED_RESULT static std::shared_ptr<const MyComponents> __vectorcall update(const MyComponents& base, const MyMap& map, const MyPoint& pos);
+
+	// flood the map from a until b is reached, the answer of connected() for a map whose labels are not built yet
+	// the cells must be inside the map
+	MY_REQUIRED_RESULT static bool __vectorcall reachable(const MyMap& map, const MyPoint& a, const MyPoint& b);
+
+	// label of the cell, the cell must be inside the map
+	MY_REQUIRED_RESULT __forceinline uint32_t __vectorcall at(const int x, const int y) const
+	{
+		return chunks_[y >> chunk_shift_][static_cast<size_t>(y & ((1 << chunk_shift_) - 1)) * width_ + x];
+	}
+
+	// check both cells are passable and in the same component, the cells must be inside the map
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall connected(const MyPoint& a, const MyPoint& b) const
+	{
+		const uint32_t label = at(a.x(), a.y());
+		return (label != 0) && (label == at(b.x(), b.y()));
+	}
+
+	// check a search from a passable cell a can not reach b, a search from a collision is not judged
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall separated(const MyPoint& a, const MyPoint& b) const
+	{
+		const uint32_t label = at(a.x(), a.y());
+		return (label != 0) && (label != at(b.x(), b.y()));
+	}
+
+private:
+	int width_ = 0;
+	int height_ = 0;
+	int chunk_shift_ = 0;                   // same rows per chunk as the map
+	uint32_t next_ = 1;                     // next unused label
+	std::vector<Chunk> chunks_;
+	std::vector<uint32_t*> writable_;       // chunks owned by the version being built
+
+	// get the writable label of the cell, the chunk is cloned on its first write
+	MY_REQUIRED_RESULT uint32_t& __vectorcall mutable_at(const int x, const int y);
+};
+
+#endif
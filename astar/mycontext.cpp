@@ -0,0 +1,132 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mycontext.h"
+
+void MySearchContext::begin(const int w, const int h)
+{
+	const size_t size = static_cast<size_t>(w) * h;
+	if (slots_.size() != size)
+	{
+		// a new vector, a smaller map would otherwise keep the table of the larger one
+		std::vector<Slot>(size).swap(slots_);
+		generation_ = 0;
+	}
+
+	width_ = w;
+	height_ = h;
+
+	// on wrap-around the stale stamps could collide with the new generation
+	if (0 == ++generation_)
+	{
+		std::ranges::fill(slots_, Slot{});
+		generation_ = 1;
+	}
+
+	nodes_.reset();
+	open_list_.clear();
+	focal_list_.clear();
+}
+
+size_t MySearchContext::bytes() const
+{
+	return slots_.capacity() * sizeof(Slot) + nodes_.bytes()
+		+ (open_list_.capacity() + focal_list_.capacity()) * sizeof(Node*);
+}
+
+void MySearchContext::trim(const size_t maxNodes)
+{
+	nodes_.trim(maxNodes);
+	if (open_list_.capacity() > maxNodes)
+		open_list_.release();
+	else
+		open_list_.clear();
+
+	if (focal_list_.capacity() > maxNodes)
+		focal_list_.release();
+	else
+		focal_list_.clear();
+}
+
+// pool of this thread while it is alive, a plain pointer can still be read after the pool is gone
+static thread_local MyContextPool* t_pool = nullptr;
+
+MyContextLease::~MyContextLease()
+{
+	// handles destroyed by a static destructor run after the thread-local pools are gone
+	if ((nullptr != context_) && (nullptr != pool_) && (pool_ == t_pool))
+	{
+		pool_->release(std::move(context_));
+	}
+}
+
+MyContextPool::MyContextPool()
+{
+	t_pool = this;
+}
+
+MyContextPool::~MyContextPool()
+{
+	if (this == t_pool)
+		t_pool = nullptr;
+}
+
+MyContextPool& MyContextPool::local()
+{
+	thread_local MyContextPool pool;
+	return pool;
+}
+
+MyContextLease MyContextPool::acquire(const int w, const int h)
+{
+	// prefer a context already sized for this map, otherwise take the most recently used one
+	auto it = std::ranges::find_if(idle_, [w, h](const std::unique_ptr<MySearchContext>& context)
+		{
+			return (context->width() == w) && (context->height() == h);
+		});
+
+	if ((it == idle_.end()) && !idle_.empty())
+	{
+		it = idle_.end() - 1;
+	}
+
+	if (it != idle_.end())
+	{
+		std::unique_ptr<MySearchContext> context = std::move(*it);
+		idle_.erase(it);
+		return MyContextLease(std::move(context), this);
+	}
+
+	return MyContextLease(std::make_unique<MySearchContext>(), this);
+}
+
+void MyContextPool::release(std::unique_ptr<MySearchContext> context)
+{
+	context->trim(kKeepNodes);
+	idle_.push_back(std::move(context));
+
+	// evict the least recently used contexts until the rest fit the budget
+	size_t total = 0;
+	for (const std::unique_ptr<MySearchContext>& it : idle_)
+		total += it->bytes();
+
+	while ((idle_.size() > 1) && (total > kMaxIdleBytes))
+	{
+		total -= idle_.front()->bytes();
+		idle_.erase(idle_.begin());
+	}
+}
@@ -0,0 +1,229 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYCONTEXT_H
+#define MYCONTEXT_H
+#pragma execution_character_set("utf-8")
+#include "mypoint.h"
+#include "myheap.hpp"
+
+// open list order, the lowest f value first and the highest g value among equal f values,
+// so of the nodes that tie the one deepest along its path goes first instead of spreading over the whole tie
+struct MyNodeLess
+{
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall operator()(const Node* a, const Node* b) const
+	{
+		const int fa = a->f();
+		const int fb = b->f();
+		return (fa < fb) || ((fa == fb) && (a->g > b->g));
+	}
+};
+
+// focal list order of a bounded search, the lowest h value first and the highest g value among equal h values
+struct MyFocalLess
+{
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall operator()(const Node* a, const Node* b) const
+	{
+		return (a->h < b->h) || ((a->h == b->h) && (a->g > b->g));
+	}
+};
+
+// bump allocator for objects of one type, the blocks are kept when it is reset
+// so a warmed-up arena never touches the heap again, objects are addressed by their index as well
+template <typename T>
+class MyArena
+{
+public:
+	static constexpr size_t kBlockItems = 4096;
+
+	MyArena() = default;
+
+	MY_DISABLE_COPY(MyArena)
+
+	// release every object at once
+	__forceinline void reset() { used_ = 0; }
+
+	template <typename... Args>
+	MY_REQUIRED_RESULT __forceinline T* __vectorcall create(Args&&... args)
+	{
+		const size_t block = used_ / kBlockItems;
+		if (block == blocks_.size())
+		{
+			blocks_.emplace_back(static_cast<T*>(::operator new(sizeof(T) * kBlockItems)));
+		}
+		T* item = blocks_[block].get() + (used_++ % kBlockItems);
+		return new (item) T(std::forward<Args>(args)...);
+	}
+
+	// get the object by the order it was created in
+	MY_REQUIRED_RESULT __forceinline T* __vectorcall at(const size_t index) const
+	{
+		return blocks_[index / kBlockItems].get() + (index % kBlockItems);
+	}
+
+	MY_REQUIRED_RESULT size_t size() const { return used_; }
+
+	MY_REQUIRED_RESULT size_t bytes() const { return blocks_.size() * kBlockItems * sizeof(T); }
+
+	// release every object and free the blocks beyond the first maxItems objects
+	void __vectorcall trim(const size_t maxItems)
+	{
+		used_ = 0;
+		const size_t keep = (maxItems + kBlockItems - 1) / kBlockItems;
+		if (blocks_.size() > keep)
+		{
+			blocks_.resize(keep);
+			blocks_.shrink_to_fit();
+		}
+	}
+
+private:
+	struct Release
+	{
+		void operator()(T* p) const { ::operator delete(p); }
+	};
+
+	std::vector<std::unique_ptr<T, Release>> blocks_;
+	size_t used_ = 0;
+};
+
+// reusable state of one search: node storage, the cell to node table and the open list
+// the table is invalidated by bumping a generation counter instead of clearing it,
+// so starting a search costs time proportional to the nodes it actually touches
+// a cell of the table takes 8 bytes, the stamp and the index of its node in the arena
+class MySearchContext
+{
+	MY_DISABLE_COPY_MOVE(MySearchContext)
+public:
+	explicit MySearchContext() = default;
+
+	virtual ~MySearchContext() = default;
+
+	// prepare for a search on a map of the specific size
+	void __vectorcall begin(const int w, const int h);
+
+	MY_REQUIRED_RESULT __forceinline int width() const { return width_; }
+
+	MY_REQUIRED_RESULT __forceinline int height() const { return height_; }
+
+	// get the node of the cell in the current search, nullptr if the cell was not touched
+	MY_REQUIRED_RESULT __forceinline Node* __vectorcall node(const int index) const
+	{
+		const Slot& slot = slots_[index];
+		return (slot.stamp == generation_) ? nodes_.at(slot.node) : nullptr;
+	}
+
+	// create the node of the cell for the current search
+	MY_REQUIRED_RESULT __forceinline Node* __vectorcall create(const MyPoint& pos)
+	{
+		Slot& slot = slots_[pos.y() * width_ + pos.x()];
+		slot.stamp = generation_;
+		slot.node = static_cast<uint32_t>(nodes_.size());
+		return nodes_.create(pos);
+	}
+
+	MY_REQUIRED_RESULT __forceinline MyIndexedHeap<Node, MyNodeLess>& open_list() { return open_list_; }
+
+	MY_REQUIRED_RESULT __forceinline MyIndexedHeap<Node, MyFocalLess>& focal_list() { return focal_list_; }
+
+	// number of nodes created by the current search
+	MY_REQUIRED_RESULT __forceinline size_t touched() const { return nodes_.size(); }
+
+	// memory held by the context
+	MY_REQUIRED_RESULT size_t bytes() const;
+
+	// end the current search and free the node storage beyond maxNodes nodes
+	void __vectorcall trim(const size_t maxNodes);
+
+private:
+	struct Slot
+	{
+		uint32_t stamp = 0;
+		uint32_t node = 0;          // index of the node in nodes_, valid when stamp is the current generation
+	};
+
+	int width_ = 0;
+	int height_ = 0;
+	uint32_t generation_ = 0;
+	std::vector<Slot> slots_;
+	MyArena<Node> nodes_;
+	MyIndexedHeap<Node, MyNodeLess> open_list_;
+	MyIndexedHeap<Node, MyFocalLess> focal_list_;
+};
+
+class MyContextPool;
+
+// a context borrowed from a pool and handed back to it on destruction
+// released on another thread or after the pool's thread has exited, the context is freed instead
+class MyContextLease
+{
+	MY_DISABLE_COPY(MyContextLease)
+public:
+	explicit MyContextLease(std::unique_ptr<MySearchContext> context, MyContextPool* pool)
+		: context_(std::move(context))
+		, pool_(pool)
+	{}
+
+	MyContextLease(MyContextLease&& other) noexcept = default;
+
+	MyContextLease& operator=(MyContextLease&& other) noexcept = default;
+
+	~MyContextLease();
+
+	MY_REQUIRED_RESULT __forceinline MySearchContext* get() const { return context_.get(); }
+
+	MY_REQUIRED_RESULT __forceinline MySearchContext* operator->() const { return context_.get(); }
+
+private:
+	std::unique_ptr<MySearchContext> context_;
+	MyContextPool* pool_ = nullptr;         // the pool the context came from
+};
+
+// per-thread pool of search contexts kept between queries
+// a context remembers the map size it was last used for, so queries on the same map
+// reuse a table of the right size instead of reallocating it
+class MyContextPool
+{
+	MY_DISABLE_COPY_MOVE(MyContextPool)
+
+	// memory of the idle contexts kept per thread, the most recently released one is kept whatever its size
+	static constexpr size_t kMaxIdleBytes = 32ull * 1024 * 1024;
+
+	// nodes a released context keeps storage for, what one large search used beyond it is freed
+	static constexpr size_t kKeepNodes = 64 * MyArena<Node>::kBlockItems;
+
+public:
+	explicit MyContextPool();
+
+	virtual ~MyContextPool();
+
+	// get the pool of the calling thread
+	MY_REQUIRED_RESULT static MyContextPool& local();
+
+	// borrow a context for a map of the specific size
+	MY_REQUIRED_RESULT MyContextLease __vectorcall acquire(const int w, const int h);
+
+private:
+	friend class MyContextLease;
+
+	std::vector<std::unique_ptr<MySearchContext>> idle_;
+
+	void __vectorcall release(std::unique_ptr<MySearchContext> context);
+};
+
+#endif
@@ -0,0 +1,312 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mydstar.h"
+
+constexpr int kStepValue = 10;
+constexpr int kObliqueValue = 14;
+
+MyDStarLite::MyDStarLite(const MyPoint& goal, const bool corner)
+	: goal_(goal)
+	, corner_(corner)
+{
+}
+
+void MyDStarLite::changed(const MyPoint& pos, const uint64_t version)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	pending_.emplace_back(pos, version);
+}
+
+void MyDStarLite::reset(const uint64_t version)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	pending_.clear();
+	reset_ = version;
+}
+
+int MyDStarLite::estimate(const MyPoint& a, const MyPoint& b) const
+{
+	const int dx = std::abs(a.x() - b.x());
+	const int dy = std::abs(a.y() - b.y());
+	if (!corner_)
+		return (dx + dy) * kStepValue;
+
+	return (std::max)(dx, dy) * kStepValue + (std::min)(dx, dy) * (kObliqueValue - kStepValue);
+}
+
+int MyDStarLite::cost(const MyPoint& a, const MyPoint& b) const
+{
+	const MyMap& map = *map_;
+	if (!map.is_road(a.x(), a.y()) || !map.is_road(b.x(), b.y()))
+		return kInfinity;
+
+	const int dx = b.x() - a.x();
+	const int dy = b.y() - a.y();
+	if ((dx == 0) || (dy == 0))
+		return kStepValue;
+
+	// same corner rule as MyAStar: both straight neighbours must be passable
+	return (map.is_road(a.x() + dx, a.y()) && map.is_road(a.x(), a.y() + dy)) ? kObliqueValue : kInfinity;
+}
+
+MyDStarLite::Key MyDStarLite::calculate_key(const MyPoint& pos, const Cell& cell) const
+{
+	const int g = (std::min)(cell.g, cell.rhs);
+	return Key{ g + estimate(start_, pos) + km_, g };
+}
+
+int MyDStarLite::neighbours(const MyPoint& pos, MyPoint* out) const
+{
+	const int x = pos.x();
+	const int y = pos.y();
+	int count = 0;
+	int dx = 0;
+	for (int dy = -1; dy <= 1; ++dy)
+	{
+		for (dx = -1; dx <= 1; ++dx)
+		{
+			if (((dx == 0) && (dy == 0)) || (!corner_ && (dx != 0) && (dy != 0)))
+				continue;
+			if (map_->contains(x + dx, y + dy))
+				out[count++] = MyPoint{ x + dx, y + dy };
+		}
+	}
+	return count;
+}
+
+void MyDStarLite::initialize()
+{
+	cells_.assign(static_cast<size_t>(map_->width) * map_->height, Cell{});
+	heap_.clear();
+	km_ = 0;
+
+	Cell& goal = cells_[index_of(goal_)];
+	goal.rhs = 0;
+	goal.key = calculate_key(goal_, goal);
+	goal.open = true;
+	heap_.push_back(Entry{ goal.key, index_of(goal_) });
+}
+
+int MyDStarLite::lookahead(const MyPoint& pos) const
+{
+	if (pos == goal_)
+		return 0;
+
+	int rhs = kInfinity;
+	MyPoint around[8];
+	const int count = neighbours(pos, around);
+	for (int i = 0; i < count; ++i)
+	{
+		const int g = cells_[index_of(around[i])].g;
+		if (g >= kInfinity)
+			continue;
+
+		const int c = cost(pos, around[i]);
+		if (c < kInfinity)
+			rhs = (std::min)(rhs, c + g);
+	}
+	return rhs;
+}
+
+void MyDStarLite::queue(const MyPoint& pos)
+{
+	const int index = index_of(pos);
+	Cell& cell = cells_[index];
+	cell.open = false;
+	if (cell.g != cell.rhs)
+	{
+		cell.key = calculate_key(pos, cell);
+		cell.open = true;
+		heap_.push_back(Entry{ cell.key, index });
+		std::ranges::push_heap(heap_, std::greater<Entry>());
+	}
+}
+
+void MyDStarLite::update_vertex(const MyPoint& pos)
+{
+	cells_[index_of(pos)].rhs = lookahead(pos);
+	queue(pos);
+}
+
+void MyDStarLite::compute_shortest_path()
+{
+	const int start = index_of(start_);
+	MyPoint around[8];
+	int count = 0;
+
+	for (;;)
+	{
+		// drop the entries of cells that were requeued or settled since
+		while (!heap_.empty())
+		{
+			const Entry& top = heap_.front();
+			const Cell& cell = cells_[top.index];
+			if (cell.open && (cell.key == top.key))
+				break;
+
+			std::ranges::pop_heap(heap_, std::greater<Entry>());
+			heap_.pop_back();
+		}
+
+		if (heap_.empty())
+			break;
+
+		const Cell start_cell = cells_[start];
+		if (!(heap_.front().key < calculate_key(start_, start_cell)) && (start_cell.rhs == start_cell.g))
+			break;
+
+		std::ranges::pop_heap(heap_, std::greater<Entry>());
+		const Entry top = heap_.back();
+		heap_.pop_back();
+
+		const MyPoint pos = point_of(top.index);
+		Cell& cell = cells_[top.index];
+		const Key key = calculate_key(pos, cell);
+		if (top.key < key)
+		{
+			// the start moved since the cell was queued
+			cell.key = key;
+			heap_.push_back(Entry{ key, top.index });
+			std::ranges::push_heap(heap_, std::greater<Entry>());
+		}
+		else if (cell.g > cell.rhs)
+		{
+			// the cell got cheaper, it can only lower the lookahead of its neighbours
+			cell.g = cell.rhs;
+			cell.open = false;
+			count = neighbours(pos, around);
+			for (int i = 0; i < count; ++i)
+			{
+				Cell& next = cells_[index_of(around[i])];
+				const int c = cost(around[i], pos);
+				if ((around[i] != goal_) && (c < kInfinity) && (c + cell.g < next.rhs))
+				{
+					next.rhs = c + cell.g;
+					queue(around[i]);
+				}
+			}
+		}
+		else
+		{
+			// the cell got dearer, only the neighbours that depended on it need their lookahead again
+			const int old = cell.g;
+			cell.g = kInfinity;
+			update_vertex(pos);
+			count = neighbours(pos, around);
+			for (int i = 0; i < count; ++i)
+			{
+				const Cell& next = cells_[index_of(around[i])];
+				const int c = cost(around[i], pos);
+				if ((c < kInfinity) && (c + old == next.rhs))
+					update_vertex(around[i]);
+			}
+		}
+	}
+}
+
+bool MyDStarLite::replan(const MyMapPtr& map, const MyPoint& start, std::vector<MyPoint>* path)
+{
+	std::lock_guard<std::mutex> slck(search_mutex_);
+	if ((nullptr == map) || !map->contains(start.x(), start.y()) || !map->contains(goal_.x(), goal_.y()))
+		return false;
+
+	// take the changes the map already contains, newer ones stay for the next replan
+	std::vector<MyPoint> changes;
+	bool fresh = (nullptr == map_) || (map_->width != map->width) || (map_->height != map->height);
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		if ((0 != reset_) && (reset_ <= map->version))
+		{
+			fresh = true;
+			reset_ = 0;
+		}
+
+		auto it = std::ranges::partition(pending_, [&map](const auto& change) { return change.second > map->version; }).begin();
+		for (auto applied = it; applied != pending_.end(); ++applied)
+			changes.push_back(applied->first);
+		pending_.erase(it, pending_.end());
+	}
+
+	if (fresh)
+	{
+		map_ = map;
+		start_ = start;
+		initialize();
+	}
+	else
+	{
+		// the keys already queued are lower bounds for the new start once km grows by the drift
+		km_ += estimate(start_, start);
+		start_ = start;
+		map_ = map;
+
+		MyPoint around[8];
+		for (const MyPoint& pos : changes)
+		{
+			update_vertex(pos);
+			const int count = neighbours(pos, around);
+			for (int i = 0; i < count; ++i)
+				update_vertex(around[i]);
+		}
+	}
+
+	if (!map_->is_road(start.x(), start.y()) || !map_->is_road(goal_.x(), goal_.y()))
+		return false;
+
+	compute_shortest_path();
+
+	// walk down the cost-to-goal values
+	MyPoint current = start;
+	MyPoint around[8];
+	const size_t limit = static_cast<size_t>(map_->width) * map_->height;
+	while (current != goal_)
+	{
+		if ((cells_[index_of(current)].g >= kInfinity) || (path->size() >= limit))
+		{
+			path->clear();
+			return false;
+		}
+
+		int best = kInfinity;
+		MyPoint step = current;
+		const int count = neighbours(current, around);
+		for (int i = 0; i < count; ++i)
+		{
+			const int g = cells_[index_of(around[i])].g;
+			if (g >= kInfinity)
+				continue;
+
+			const int c = cost(current, around[i]);
+			if ((c < kInfinity) && (c + g < best))
+			{
+				best = c + g;
+				step = around[i];
+			}
+		}
+
+		if (best >= kInfinity)
+		{
+			path->clear();
+			return false;
+		}
+
+		path->push_back(step);
+		current = step;
+	}
+	return true;
+}
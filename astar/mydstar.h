@@ -0,0 +1,122 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYDSTAR_H
+#define MYDSTAR_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+
+// D* Lite: a persistent search from the goal towards a moving start
+// edits reported through changed() are repaired on the next replan() instead of searching again,
+// so a replan after a local change costs time in proportion to the area it affects
+// costs and the corner rule are the same as MyAStar, the start and the goal must be passable
+class MyDStarLite
+{
+	MY_DISABLE_COPY_MOVE(MyDStarLite)
+public:
+	explicit MyDStarLite(const MyPoint& goal, const bool corner);
+
+	virtual ~MyDStarLite() = default;
+
+	MY_REQUIRED_RESULT __forceinline const MyPoint& goal() const { return goal_; }
+
+	// a cell changed in the version, safe to call from any thread
+	void __vectorcall changed(const MyPoint& pos, const uint64_t version);
+
+	// the map was replaced by the version, safe to call from any thread
+	void __vectorcall reset(const uint64_t version);
+
+	// repair the search for the map and the current start and get the path, start excluded
+	// only the changes reported up to the version of the map are applied, later ones wait for the next replan
+	MY_REQUIRED_RESULT bool __vectorcall replan(const MyMapPtr& map, const MyPoint& start, std::vector<MyPoint>* path);
+
+private:
+	static constexpr int kInfinity = INT_MAX / 4;
+
+	// lexicographic priority of D* Lite
+	struct Key
+	{
+		int k1 = 0;
+		int k2 = 0;
+
+		bool operator< (const Key& other) const { return (k1 < other.k1) || ((k1 == other.k1) && (k2 < other.k2)); }
+		bool operator== (const Key& other) const { return (k1 == other.k1) && (k2 == other.k2); }
+	};
+
+	struct Cell
+	{
+		int g = kInfinity;
+		int rhs = kInfinity;
+		Key key = {};
+		bool open = false;                  // the heap entry with this key is the live one
+	};
+
+	// heap entry, stale entries are skipped when popped
+	struct Entry
+	{
+		Key key;
+		int index = 0;
+
+		bool operator> (const Entry& other) const { return other.key < key; }
+	};
+
+	std::mutex mutex_;                      // guards the notifications
+	std::vector<std::pair<MyPoint, uint64_t>> pending_;  // cells changed since the last replan and their versions
+	uint64_t reset_ = 0;                    // version that replaced the map, 0 if none is pending
+
+	std::mutex search_mutex_;               // one replan at a time
+
+	MyMapPtr map_ = nullptr;
+	MyPoint goal_ = {};
+	MyPoint start_ = {};
+	bool corner_ = true;
+	int km_ = 0;                            // sum of the heuristic drift of the moving start
+	std::vector<Cell> cells_;              // one per cell of the map, row by row
+	std::vector<Entry> heap_;
+
+	// start the search from scratch on the map
+	void __vectorcall initialize();
+
+	// heuristic distance, octile for 8-dir and manhattan for 4-dir
+	MY_REQUIRED_RESULT int __vectorcall estimate(const MyPoint& a, const MyPoint& b) const;
+
+	// cost of the single step from a to its neighbour b, kInfinity if blocked
+	MY_REQUIRED_RESULT int __vectorcall cost(const MyPoint& a, const MyPoint& b) const;
+
+	MY_REQUIRED_RESULT Key __vectorcall calculate_key(const MyPoint& pos, const Cell& cell) const;
+
+	// one-step lookahead cost to the goal (rhs) from the g values of the neighbours
+	MY_REQUIRED_RESULT int __vectorcall lookahead(const MyPoint& pos) const;
+
+	// queue the cell if it is inconsistent
+	void __vectorcall queue(const MyPoint& pos);
+
+	// recompute rhs of the cell and queue it if it is inconsistent
+	void __vectorcall update_vertex(const MyPoint& pos);
+
+	void __vectorcall compute_shortest_path();
+
+	// the cells around pos inside the map, return the count
+	MY_REQUIRED_RESULT int __vectorcall neighbours(const MyPoint& pos, MyPoint* out) const;
+
+	MY_REQUIRED_RESULT __forceinline int __vectorcall index_of(const MyPoint& pos) const { return pos.y() * map_->width + pos.x(); }
+
+	MY_REQUIRED_RESULT __forceinline MyPoint __vectorcall point_of(const int index) const { return MyPoint{ index % map_->width, index / map_->width }; }
+};
+
+#endif
@@ -0,0 +1,195 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "myflowfield.h"
+
+constexpr int kStepValue = 10;
+constexpr int kObliqueValue = 14;
+
+// offsets of the directions, 0 = up and clockwise
+constexpr int kDirX[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+constexpr int kDirY[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+std::shared_ptr<const MyFlowField> MyFlowField::build(const MyMap& map, const MyPoint& goal, const bool corner)
+{
+	if (!map.contains(goal.x(), goal.y()) || !map.is_road(goal.x(), goal.y()))
+		return nullptr;
+
+	const int width = map.width;
+	const size_t cells = static_cast<size_t>(map.width) * map.height;
+
+	std::shared_ptr<MyFlowField> field = std::make_shared<MyFlowField>();
+	field->width_ = map.width;
+	field->height_ = map.height;
+	field->goal_ = goal;
+	field->corner_ = corner;
+	field->version_ = map.version;
+	field->dist_.assign(cells, kUnreachable);
+	field->dirs_.assign((cells + kPerWord - 1) / kPerWord, 0);
+
+	// exact costs while flooding, folded into 16 bits afterwards
+	std::vector<int> cost(cells, -1);
+
+	// Dial's buckets: a step costs at most kObliqueValue, so a ring of buckets replaces the priority queue
+	constexpr int kBuckets = kObliqueValue + 1;
+	std::vector<int> buckets[kBuckets];
+	size_t pending = 1;
+
+	const int source = goal.y() * width + goal.x();
+	cost[source] = 0;
+	buckets[0].push_back(source);
+
+	for (int g = 0; pending > 0; ++g)
+	{
+		std::vector<int>& bucket = buckets[g % kBuckets];
+		while (!bucket.empty())
+		{
+			const int index = bucket.back();
+			bucket.pop_back();
+			--pending;
+			if (g != cost[index])
+				continue;
+
+			const int x = index % width;
+			const int y = index / width;
+			auto passable = [&map](const int nx, const int ny)
+			{
+				return map.contains(nx, ny) && map.is_road(nx, ny);
+			};
+
+			// a step from the neighbour back to this cell, the corner rule is symmetric
+			bool straight[8] = {};
+			int dir = 0;
+			for (dir = 0; dir < 8; dir += 2)
+				straight[dir] = passable(x + kDirX[dir], y + kDirY[dir]);
+
+			for (dir = 0; dir < 8; ++dir)
+			{
+				const int nx = x + kDirX[dir];
+				const int ny = y + kDirY[dir];
+				const bool oblique = (dir & 1) != 0;
+				if (oblique)
+				{
+					if (!corner || !straight[dir - 1] || !straight[(dir + 1) & 7] || !passable(nx, ny))
+						continue;
+				}
+				else if (!straight[dir])
+				{
+					continue;
+				}
+
+				const int next = ny * width + nx;
+				const int c = g + (oblique ? kObliqueValue : kStepValue);
+				if ((cost[next] >= 0) && (cost[next] <= c))
+					continue;
+
+				cost[next] = c;
+				buckets[c % kBuckets].push_back(next);
+				++pending;
+
+				// the neighbour steps back in the opposite direction
+				const size_t word = static_cast<size_t>(next) / kPerWord;
+				const int shift = static_cast<int>((static_cast<size_t>(next) % kPerWord) * 3);
+				field->dirs_[word] = (field->dirs_[word] & ~(7ULL << shift)) | (static_cast<uint64_t>((dir + 4) & 7) << shift);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < cells; ++i)
+	{
+		if (cost[i] >= 0)
+			field->dist_[i] = static_cast<uint16_t>((std::min)(cost[i], static_cast<int>(kMaxDistance)));
+	}
+
+	return field;
+}
+
+bool MyFlowField::next(const MyPoint& pos, MyPoint* out) const
+{
+	if ((pos.x() < 0) || (pos.x() >= width_) || (pos.y() < 0) || (pos.y() >= height_))
+		return false;
+
+	const uint16_t dist = distance(pos.x(), pos.y());
+	if ((kUnreachable == dist) || (pos == goal_))
+		return false;
+
+	const int dir = direction(pos.x(), pos.y());
+	*out = MyPoint{ pos.x() + kDirX[dir], pos.y() + kDirY[dir] };
+	return true;
+}
+
+bool MyFlowField::path(const MyPoint& start, std::vector<MyPoint>* path) const
+{
+	if ((start.x() < 0) || (start.x() >= width_) || (start.y() < 0) || (start.y() >= height_)
+		|| (kUnreachable == distance(start.x(), start.y())))
+	{
+		return false;
+	}
+
+	MyPoint pos = start;
+	MyPoint step = {};
+	while (next(pos, &step))
+	{
+		path->push_back(step);
+		pos = step;
+	}
+	return true;
+}
+
+std::shared_ptr<const MyFlowField> MyFlowCache::get(const std::wstring& mapid, const MyMap& map, const MyPoint& goal, const bool corner)
+{
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		for (Entry& entry : entries_)
+		{
+			const MyFlowField& field = *entry.field;
+			if ((field.version() == map.version) && (field.goal() == goal) && (field.corner() == corner) && (entry.mapid == mapid))
+			{
+				entry.used = ++tick_;
+				return entry.field;
+			}
+		}
+	}
+
+	// build without holding the lock, two threads missing at once just build it twice
+	std::shared_ptr<const MyFlowField> field = MyFlowField::build(map, goal, corner);
+	if (nullptr == field)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lck(mutex_);
+
+	// fields of older versions for the same goal can never be hit again
+	std::erase_if(entries_, [&mapid, &goal, corner](const Entry& entry)
+		{
+			return (entry.mapid == mapid) && (entry.field->goal() == goal) && (entry.field->corner() == corner);
+		});
+
+	if (entries_.size() >= kMaxFields)
+	{
+		auto oldest = std::ranges::min_element(entries_, {}, &Entry::used);
+		entries_.erase(oldest);
+	}
+
+	entries_.push_back(Entry{ mapid, field, ++tick_ });
+	return field;
+}
+
+void MyFlowCache::erase(const std::wstring& mapid)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	std::erase_if(entries_, [&mapid](const Entry& entry) { return entry.mapid == mapid; });
+}
@@ -0,0 +1,108 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYFLOWFIELD_H
+#define MYFLOWFIELD_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+
+// distance and next step towards one goal for every cell of a map version (reverse Dijkstra)
+// any number of agents sharing the goal read their paths in O(path length) without searching
+// a cell takes a 16-bit distance plus a 3-bit direction, 21 directions are packed per 64-bit word
+class MyFlowField
+{
+	MY_DISABLE_COPY_MOVE(MyFlowField)
+public:
+	static constexpr uint16_t kUnreachable = 0xffff;
+	static constexpr uint16_t kMaxDistance = 0xfffe;    // longer distances are saturated, the directions stay exact
+
+	explicit MyFlowField() = default;
+
+	virtual ~MyFlowField() = default;
+
+	// build the field of the goal, nullptr if the goal is outside the map or not passable
+	MY_REQUIRED_RESULT static std::shared_ptr<const MyFlowField> __vectorcall build(const MyMap& map, const MyPoint& goal, const bool corner);
+
+	MY_REQUIRED_RESULT __forceinline const MyPoint& goal() const { return goal_; }
+
+	MY_REQUIRED_RESULT __forceinline bool corner() const { return corner_; }
+
+	MY_REQUIRED_RESULT __forceinline uint64_t version() const { return version_; }
+
+	// cost to the goal, kUnreachable if the goal can not be reached, the cell must be inside the map
+	MY_REQUIRED_RESULT __forceinline uint16_t __vectorcall distance(const int x, const int y) const
+	{
+		return dist_[static_cast<size_t>(y) * width_ + x];
+	}
+
+	// direction of the next step (0 = up, clockwise), only meaningful for reachable cells other than the goal
+	MY_REQUIRED_RESULT __forceinline int __vectorcall direction(const int x, const int y) const
+	{
+		const size_t index = static_cast<size_t>(y) * width_ + x;
+		return static_cast<int>((dirs_[index / kPerWord] >> ((index % kPerWord) * 3)) & 7ULL);
+	}
+
+	// get the next cell towards the goal, false at the goal or if the goal can not be reached
+	MY_REQUIRED_RESULT bool __vectorcall next(const MyPoint& pos, MyPoint* out) const;
+
+	// append the cells from start to the goal excluding start, the same layout as MyAStar::find
+	MY_REQUIRED_RESULT bool __vectorcall path(const MyPoint& start, std::vector<MyPoint>* path) const;
+
+private:
+	static constexpr size_t kPerWord = 21;
+
+	int width_ = 0;
+	int height_ = 0;
+	MyPoint goal_ = {};
+	bool corner_ = true;
+	uint64_t version_ = 0;
+	std::vector<uint16_t> dist_;
+	std::vector<uint64_t> dirs_;
+};
+
+// the most recently used flow fields, a field is only handed out for the version it was built from
+class MyFlowCache
+{
+	MY_DISABLE_COPY_MOVE(MyFlowCache)
+public:
+	static constexpr size_t kMaxFields = 16;
+
+	explicit MyFlowCache() = default;
+
+	virtual ~MyFlowCache() = default;
+
+	// get the field of the goal for the map version, built on a miss, nullptr if the goal is invalid
+	MY_REQUIRED_RESULT std::shared_ptr<const MyFlowField> __vectorcall get(const std::wstring& mapid, const MyMap& map, const MyPoint& goal, const bool corner);
+
+	// drop every field of the map
+	void __vectorcall erase(const std::wstring& mapid);
+
+private:
+	struct Entry
+	{
+		std::wstring mapid;
+		std::shared_ptr<const MyFlowField> field;
+		uint64_t used = 0;
+	};
+
+	std::mutex mutex_;
+	std::vector<Entry> entries_;
+	uint64_t tick_ = 0;
+};
+
+#endif
@@ -1,117 +1,165 @@
-﻿/*
-* Copyright (c) 2019-2022 bestkakkoii llc.
-*
-* This software is provided 'as-is', without any express or implied
-* warranty.  In no event will the authors be held liable for any damages
-* arising from the use of this software.
-* Permission is granted to anyone to use this software for any purpose,
-* including commercial applications, and to alter it and redistribute it
-* freely, subject to the following restrictions:
-* 1. The origin of this software must not be misrepresented; you must not
-* claim that you wrote the original software. If you use this software
-* in a product, an acknowledgment in the product documentation would be
-* appreciated but is not required.
-* 2. Altered source versions must be plainly marked as such, and must not be
-* misrepresented as being the original software.
-* 3. This notice may not be removed or altered from any source distribution.
-*/
-#pragma once
-#ifndef MYGLOBAL_H
-#define MYGLOBAL_H
-#pragma execution_character_set("utf-8")
-#define WIN32_LEAN_AND_MEAN
-
-#include <windows.h>
-#include <cassert>
-#include <cstring>
-#include <fstream>
-#include <sstream>
-#include <iostream>
-
-#include <math.h>
-#include <cmath>
-#include <algorithm>
-
-#include <stdexcept>
-#include <vector>
-#include <format>
-#include <ranges>
-#include <memory>
-#include <functional>
-
-#include <condition_variable>
-#include <mutex>
-#include <shared_mutex>
-
-//3rd party
-#include "blockallocator.h"
-
-typedef unsigned char       uint8_t;
-typedef unsigned short     uint16_t;
-typedef unsigned int       uint32_t;
-
-#define MY_DISABLE_COPY(Class) \
-    Class(const Class &) = delete;\
-    Class &operator=(const Class &) = delete;
-
-#define MY_DISABLE_MOVE(Class) \
-    Class(Class &&) = delete; \
-    Class &operator=(Class &&) = delete;
-
-#define MY_DISABLE_COPY_MOVE(Class) \
-    MY_DISABLE_COPY(Class) \
-    MY_DISABLE_MOVE(Class)
-
-#if __has_cpp_attribute(nodiscard)
-#  undef MY_REQUIRED_RESULT
-#  define MY_REQUIRED_RESULT [[nodiscard]]
-#endif
-
-#  define MY_CHECK_PTR(p) do { if (!(p)) throw std::bad_alloc{}; } while (false)
-
-template <typename T>
-inline T* my_check_ptr(T* p) { MY_CHECK_PTR(p); return p; }
-
-struct MyRGB
-{
-	uint8_t r;
-	uint8_t g;
-	uint8_t b;
-
-	bool operator==(const MyRGB& rhs) const
-	{
-		return (r == rhs.r) && (g == rhs.g) && (b == rhs.b);
-	}
-};
-
-typedef struct tagBitmapFileHeader
-{
-	char bfType[2]; // must be "BM"
-	char bfSize[4]; // the size of the bmp file
-	char bfReserved1[2];
-	char bfReserved2[2];
-	char bfOffBits[4]; // the offset to the bitmap data
-} BitMapFileHeader;
-
-typedef struct tagBitmapInfoHeader
-{
-	char biSize[4]; // the size of BITMAPINFOHEADER
-	char biWidth[4]; // width (pixels)
-	char biHeight[4]; // height (pixels)
-	char biPlanes[2]; // color planes
-	char biBitCount[2]; // bits per pixel
-	char biCompression[4]; // type of compression (0 is no compression)
-	char biSizeImage[4]; // the origin size of the bitmap data (before compression)
-	char biXPelsPerMeter[4]; // horizontal pixels per meter
-	char biYPelsPerMeter[4]; // vertical pixels per meter
-	char biClrUsed[4]; // the number of colors used
-	char biClrImportant[4]; // "important" colors, usually 0
-} BitmapInfoHeader;
-
-typedef enum
-{
-	TYPE_COLLISION,
-	TYPE_ROAD,
-}OBJECTTYPE;
-
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYGLOBAL_H
+#define MYGLOBAL_H
+#pragma execution_character_set("utf-8")
+#define WIN32_LEAN_AND_MEAN
+
+#include <windows.h>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <math.h>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#include <stdexcept>
+#include <vector>
+#include <deque>
+#include <list>
+#include <map>
+#include <optional>
+#include <variant>
+#include <unordered_map>
+#include <format>
+#include <ranges>
+#include <memory>
+#include <utility>
+#include <chrono>
+#include <bit>
+#include <emmintrin.h>
+#include <functional>
+
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+
+//3rd party
+#include "blockallocator.h"
+
+typedef unsigned char       uint8_t;
+typedef unsigned short     uint16_t;
+typedef unsigned int       uint32_t;
+
+#define MY_DISABLE_COPY(Class) \
+    Class(const Class &) = delete;\
+    Class &operator=(const Class &) = delete;
+
+#define MY_DISABLE_MOVE(Class) \
+    Class(Class &&) = delete; \
+    Class &operator=(Class &&) = delete;
+
+#define MY_DISABLE_COPY_MOVE(Class) \
+    MY_DISABLE_COPY(Class) \
+    MY_DISABLE_MOVE(Class)
+
+#if __has_cpp_attribute(nodiscard)
+#  undef MY_REQUIRED_RESULT
+#  define MY_REQUIRED_RESULT [[nodiscard]]
+#endif
+
+#  define MY_CHECK_PTR(p) do { if (!(p)) throw std::bad_alloc{}; } while (false)
+
+template <typename T>
+inline T* my_check_ptr(T* p) { MY_CHECK_PTR(p); return p; }
+
+struct MyRGB
+{
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+
+	bool operator==(const MyRGB& rhs) const
+	{
+		return (r == rhs.r) && (g == rhs.g) && (b == rhs.b);
+	}
+};
+
+typedef struct tagBitmapFileHeader
+{
+	char bfType[2]; // must be "BM"
+	char bfSize[4]; // the size of the bmp file
+	char bfReserved1[2];
+	char bfReserved2[2];
+	char bfOffBits[4]; // the offset to the bitmap data
+} BitMapFileHeader;
+
+typedef struct tagBitmapInfoHeader
+{
+	char biSize[4]; // the size of BITMAPINFOHEADER
+	char biWidth[4]; // width (pixels)
+	char biHeight[4]; // height (pixels)
+	char biPlanes[2]; // color planes
+	char biBitCount[2]; // bits per pixel
+	char biCompression[4]; // type of compression (0 is no compression)
+	char biSizeImage[4]; // the origin size of the bitmap data (before compression)
+	char biXPelsPerMeter[4]; // horizontal pixels per meter
+	char biYPelsPerMeter[4]; // vertical pixels per meter
+	char biClrUsed[4]; // the number of colors used
+	char biClrImportant[4]; // "important" colors, usually 0
+} BitmapInfoHeader;
+
+typedef enum
+{
+	TYPE_COLLISION,
+	TYPE_ROAD,
+}OBJECTTYPE;
+
+// search engine of a path query
+typedef enum
+{
+	ENGINE_DEFAULT = -1,    // the engine set for the map
+	ENGINE_ASTAR,           // plain A*, works for 4-dir and 8-dir
+	ENGINE_JPS,             // Jump Point Search, 8-dir only, 4-dir queries fall back to A*
+	ENGINE_HPA,             // hierarchical A* over the map's cluster graph, A* if the map has none
+	ENGINE_BIASTAR,         // bidirectional A* meeting in the middle, returns a shortest path
+}ENGINETYPE;
+
+// result of a search, a search stopped by a limit still returns the path to the node closest to the end
+typedef enum
+{
+	SEARCH_NOPATH = 0,      // no path, or the map or a point is invalid
+	SEARCH_FOUND = 1,       // the path reaches the end point
+	SEARCH_EXPANSIONS = 2,  // stopped by the expansion limit
+	SEARCH_TIMEOUT = 3,     // stopped by the time limit
+}SEARCHSTATUS;
+
+// bounded-suboptimal search, the path costs at most (1 + epsilon) times the shortest one
+typedef enum
+{
+	BOUND_WEIGHTED = 0,     // weighted A*, the heuristic is scaled by 1 + epsilon
+	BOUND_FOCAL = 1,        // focal search, the node closest to the end among those with f within 1 + epsilon of the lowest f
+}BOUNDMODE;
+
+// binary encoding of a path, the points are the same ones start returns (the start point is not included)
+typedef enum
+{
+	PATH_POINTS = 0,        // int32 x, y of every point
+	PATH_DELTA = 1,         // int32 x, y of the first point, then int8 dx, dy from the previous point
+	PATH_VARINT = 2,        // LEB128 varints of zigzag x, y of the first point, then of dx, dy from the previous point
+	PATH_TURNS = 0x100,     // flag, keep only the points where the direction changes and the last point
+}PATHENCODING;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYHEAP_H
+#define MYHEAP_H
+#pragma execution_character_set("utf-8")
+#include "myglobal.hpp"
+
+// binary min-heap of T* where every element remembers its own position in T::heap_index
+// (-1 when not in the heap), so a changed key is restored in O(log n) without searching
+// Less(a, b) returns true if a must be popped before b
+template <typename T, typename Less>
+class MyIndexedHeap
+{
+public:
+	explicit MyIndexedHeap(const Less& less = Less{})
+		: less_(less)
+	{}
+
+	MY_REQUIRED_RESULT __forceinline bool empty() const { return items_.empty(); }
+
+	MY_REQUIRED_RESULT __forceinline size_t size() const { return items_.size(); }
+
+	MY_REQUIRED_RESULT __forceinline T* top() const { return items_.front(); }
+
+	MY_REQUIRED_RESULT __forceinline bool contains(const T* item) const { return item->heap_index >= 0; }
+
+	// direct access for scans over the whole open list, the order is unspecified
+	MY_REQUIRED_RESULT __forceinline T* at(const size_t index) const { return items_[index]; }
+
+	void reserve(const size_t count) { items_.reserve(count); }
+
+	MY_REQUIRED_RESULT size_t capacity() const { return items_.capacity(); }
+
+	// forget all items and give back the storage
+	void release()
+	{
+		items_.clear();
+		items_.shrink_to_fit();
+	}
+
+	// forget all items, the items keep their stale heap_index
+	void clear() { items_.clear(); }
+
+	void __vectorcall push(T* item)
+	{
+		item->heap_index = static_cast<int>(items_.size());
+		items_.push_back(item);
+		sift_up(item->heap_index);
+	}
+
+	T* pop()
+	{
+		T* item = items_.front();
+		remove_at(0);
+		return item;
+	}
+
+	// the key of the item decreased
+	void __vectorcall decrease(T* item)
+	{
+		sift_up(item->heap_index);
+	}
+
+	// the key of the item changed in any direction
+	void __vectorcall update(T* item)
+	{
+		if (!sift_up(item->heap_index))
+			sift_down(item->heap_index);
+	}
+
+	void __vectorcall remove(T* item)
+	{
+		remove_at(item->heap_index);
+	}
+
+private:
+	Less less_;
+	std::vector<T*> items_;
+
+	__forceinline void __vectorcall place(T* item, const int index)
+	{
+		items_[index] = item;
+		item->heap_index = index;
+	}
+
+	void __vectorcall remove_at(const int index)
+	{
+		items_[index]->heap_index = -1;
+		T* last = items_.back();
+		items_.pop_back();
+		if (index < static_cast<int>(items_.size()))
+		{
+			place(last, index);
+			update(last);
+		}
+	}
+
+	// return true if the item moved
+	bool __vectorcall sift_up(int hole)
+	{
+		T* item = items_[hole];
+		const int origin = hole;
+		while (hole > 0)
+		{
+			const int parent = (hole - 1) >> 1;
+			if (!less_(item, items_[parent]))
+				break;
+
+			place(items_[parent], hole);
+			hole = parent;
+		}
+		place(item, hole);
+		return hole != origin;
+	}
+
+	void __vectorcall sift_down(int hole)
+	{
+		T* item = items_[hole];
+		const int size = static_cast<int>(items_.size());
+		for (;;)
+		{
+			int child = (hole << 1) + 1;
+			if (child >= size)
+				break;
+
+			if (((child + 1) < size) && less_(items_[child + 1], items_[child]))
+				++child;
+
+			if (!less_(items_[child], item))
+				break;
+
+			place(items_[child], hole);
+			hole = child;
+		}
+		place(item, hole);
+	}
+};
+
+#endif
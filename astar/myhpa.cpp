@@ -0,0 +1,531 @@
+﻿#include "myhpa.h"
+
+constexpr int kStepValue = 10;
+constexpr int kObliqueValue = 14;
+
+// an opening narrower than this gets one transition in its middle, a wider one gets one at each end
+constexpr int kMaxEntranceWidth = 6;
+
+// clusters per thread pool task
+constexpr int kClustersPerTask = 16;
+
+// octile distance for 8-dir, manhattan distance for 4-dir
+static __forceinline int my_hpa_estimate(const MyPoint& a, const MyPoint& b, const bool corner)
+{
+	const int dx = std::abs(a.x() - b.x());
+	const int dy = std::abs(a.y() - b.y());
+	if (!corner)
+		return (dx + dy) * kStepValue;
+
+	return (std::max)(dx, dy) * kStepValue + (std::min)(dx, dy) * (kObliqueValue - kStepValue);
+}
+
+std::shared_ptr<const MyHpaGraph> MyHpaGraph::build(const MyMap& map, const int cluster_size, const bool corner)
+{
+	if ((cluster_size < 2) || (map.width <= 0) || (map.height <= 0))
+		return nullptr;
+
+	std::shared_ptr<MyHpaGraph> graph = std::make_shared<MyHpaGraph>();
+	graph->width_ = map.width;
+	graph->height_ = map.height;
+	graph->size_ = cluster_size;
+	graph->columns_ = (map.width + cluster_size - 1) / cluster_size;
+	graph->rows_ = (map.height + cluster_size - 1) / cluster_size;
+	graph->corner_ = corner;
+
+	const int count = graph->columns_ * graph->rows_;
+	std::vector<std::shared_ptr<Cluster>> fresh(count);
+	graph->clusters_.resize(count);
+
+	// the entrances of a cluster come from the borders of its neighbours as well,
+	// so every border is found before any cluster collects its entrances
+	for (int i = 0; i < count; ++i)
+	{
+		fresh[i] = std::make_shared<Cluster>();
+		graph->build_borders(map, i, fresh[i].get());
+		graph->clusters_[i] = fresh[i];
+	}
+
+	MyThreadPool::instance().parallel_for(count, kClustersPerTask, [&graph, &map, &fresh](const int begin, const int end)
+		{
+			for (int i = begin; i < end; ++i)
+				graph->build_nodes(map, i, fresh[i].get());
+		});
+
+	return graph;
+}
+
+std::shared_ptr<const MyHpaGraph> MyHpaGraph::update(const MyHpaGraph& base, const MyMap& map, const std::vector<MyRect>& changed)
+{
+	if ((map.width != base.width_) || (map.height != base.height_))
+		return build(map, base.size_, base.corner_);
+
+	std::shared_ptr<MyHpaGraph> graph = std::make_shared<MyHpaGraph>();
+	graph->width_ = base.width_;
+	graph->height_ = base.height_;
+	graph->size_ = base.size_;
+	graph->columns_ = base.columns_;
+	graph->rows_ = base.rows_;
+	graph->corner_ = base.corner_;
+	graph->clusters_ = base.clusters_;
+
+	// a changed cell can move the entrances on all four borders of its cluster,
+	// which changes the entrances of the four neighbours too
+	std::vector<uint8_t> dirty(graph->clusters_.size(), 0);
+	for (const MyRect& rc : changed)
+	{
+		const int left = (std::max)(rc.x, 0);
+		const int top = (std::max)(rc.y, 0);
+		const int right = (std::min)(rc.x + rc.w, base.width_);
+		const int bottom = (std::min)(rc.y + rc.h, base.height_);
+		if ((left >= right) || (top >= bottom))
+			continue;
+
+		const int cx0 = (std::max)(left / base.size_ - 1, 0);
+		const int cy0 = (std::max)(top / base.size_ - 1, 0);
+		const int cx1 = (std::min)((right - 1) / base.size_ + 1, base.columns_ - 1);
+		const int cy1 = (std::min)((bottom - 1) / base.size_ + 1, base.rows_ - 1);
+		int cx = 0;
+		for (int cy = cy0; cy <= cy1; ++cy)
+		{
+			for (cx = cx0; cx <= cx1; ++cx)
+			{
+				// the diagonal neighbours share no border with the changed clusters
+				const bool outside_x = (cx * base.size_ + base.size_ <= left) || (cx * base.size_ >= right);
+				const bool outside_y = (cy * base.size_ + base.size_ <= top) || (cy * base.size_ >= bottom);
+				if (!(outside_x && outside_y))
+					dirty[cy * base.columns_ + cx] = 1;
+			}
+		}
+	}
+
+	std::vector<int> indices;
+	std::vector<std::shared_ptr<Cluster>> fresh;
+	for (int i = 0; i < static_cast<int>(dirty.size()); ++i)
+	{
+		if (!dirty[i])
+			continue;
+
+		std::shared_ptr<Cluster> cluster = std::make_shared<Cluster>();
+		graph->build_borders(map, i, cluster.get());
+		graph->clusters_[i] = cluster;
+		indices.push_back(i);
+		fresh.push_back(std::move(cluster));
+	}
+
+	MyThreadPool::instance().parallel_for(static_cast<int>(fresh.size()), kClustersPerTask, [&graph, &map, &indices, &fresh](const int begin, const int end)
+		{
+			for (int i = begin; i < end; ++i)
+				graph->build_nodes(map, indices[i], fresh[i].get());
+		});
+
+	return graph;
+}
+
+MyRectPass MyHpaGraph::bounds(const MyMap& map, const int cluster) const
+{
+	const int left = (cluster % columns_) * size_;
+	const int top = (cluster / columns_) * size_;
+	return MyRectPass{ &map, left, top, (std::min)(left + size_, width_), (std::min)(top + size_, height_) };
+}
+
+void MyHpaGraph::build_borders(const MyMap& map, const int cluster, Cluster* out) const
+{
+	const MyRectPass rc = bounds(map, cluster);
+
+	// turn every run of open cells facing each other into one or two transitions
+	auto scan = [](const int begin, const int end, auto&& open, auto&& add)
+	{
+		int run = begin;
+		for (int i = begin; i <= end; ++i)
+		{
+			if ((i < end) && open(i))
+				continue;
+
+			const int len = i - run;
+			if (len > 0 && len < kMaxEntranceWidth)
+			{
+				add(run + len / 2);
+			}
+			else if (len > 0)
+			{
+				add(run);
+				add(i - 1);
+			}
+			run = i + 1;
+		}
+	};
+
+	if (rc.right < width_)
+	{
+		const int x = rc.right - 1;
+		scan(rc.top, rc.bottom,
+			[&map, x](const int y) { return map.is_road(x, y) && map.is_road(x + 1, y); },
+			[this, out, x](const int y) { out->east.emplace_back(y * width_ + x, y * width_ + x + 1); });
+	}
+
+	if (rc.bottom < height_)
+	{
+		const int y = rc.bottom - 1;
+		scan(rc.left, rc.right,
+			[&map, y](const int x) { return map.is_road(x, y) && map.is_road(x, y + 1); },
+			[this, out, y](const int x) { out->south.emplace_back(y * width_ + x, (y + 1) * width_ + x); });
+	}
+}
+
+void MyHpaGraph::build_nodes(const MyMap& map, const int cluster, Cluster* out) const
+{
+	std::vector<int>& nodes = out->nodes;
+	for (const auto& it : out->east)
+		nodes.push_back(it.first);
+	for (const auto& it : out->south)
+		nodes.push_back(it.first);
+	if (cluster % columns_)
+	{
+		for (const auto& it : clusters_[cluster - 1]->east)
+			nodes.push_back(it.second);
+	}
+	if (cluster >= columns_)
+	{
+		for (const auto& it : clusters_[cluster - columns_]->south)
+			nodes.push_back(it.second);
+	}
+
+	// a cell in a cluster corner can sit on two borders
+	std::ranges::sort(nodes);
+	nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+	Area area;
+	load(map, cluster, &area);
+	const int n = static_cast<int>(nodes.size());
+	out->dist.assign(static_cast<size_t>(n) * n, -1);
+
+	// the costs are symmetric, the last node is already known by everyone else
+	std::vector<int> cost;
+	int j = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		out->dist[i * n + i] = 0;
+		if (i == n - 1)
+			break;
+
+		flood(&area, nodes[i] % width_, nodes[i] / width_, &cost);
+		for (j = i + 1; j < n; ++j)
+		{
+			const int c = cost[area.index(nodes[j] % width_, nodes[j] / width_)];
+			out->dist[i * n + j] = c;
+			out->dist[j * n + i] = c;
+		}
+	}
+}
+
+void MyHpaGraph::load(const MyMap& map, const int cluster, Area* out) const
+{
+	const MyRectPass rc = bounds(map, cluster);
+	out->left = rc.left;
+	out->top = rc.top;
+	out->stride = rc.right - rc.left + 2;
+	out->open.assign(static_cast<size_t>(out->stride) * (rc.bottom - rc.top + 2), 0);
+
+	int x = 0;
+	for (int y = rc.top; y < rc.bottom; ++y)
+	{
+		uint8_t* p = out->open.data() + out->index(rc.left, y);
+		for (x = rc.left; x < rc.right; ++x)
+		{
+			*p++ = map.is_road(x, y);
+		}
+	}
+}
+
+void MyHpaGraph::flood(Area* area, const int x, const int y, std::vector<int>* cost) const
+{
+	const uint8_t* open = area->open.data();
+	const int stride = area->stride;
+	cost->assign(area->open.size(), -1);
+	int* costs = cost->data();
+
+	// Dial's buckets: a step costs at most kObliqueValue, so the pending costs always fit in
+	// kObliqueValue + 1 consecutive values and a ring of buckets replaces the priority queue
+	static_assert(Area::kBuckets > kObliqueValue);
+	std::vector<int>* buckets = area->buckets;
+	size_t pending = 1;
+
+	const int source = area->index(x, y);
+	costs[source] = 0;
+	buckets[0].push_back(source);
+
+	for (int g = 0; pending > 0; ++g)
+	{
+		std::vector<int>& bucket = buckets[g % Area::kBuckets];
+		while (!bucket.empty())
+		{
+			const int index = bucket.back();
+			bucket.pop_back();
+			--pending;
+			if (g != costs[index])
+				continue;
+
+			auto relax = [&](const int next, const int step)
+			{
+				int& c = costs[next];
+				if ((c < 0) || (g + step < c))
+				{
+					c = g + step;
+					buckets[c % Area::kBuckets].push_back(next);
+					++pending;
+				}
+			};
+
+			// the wall around the area keeps every neighbour index valid
+			const bool up = open[index - stride];
+			const bool left = open[index - 1];
+			const bool right = open[index + 1];
+			const bool down = open[index + stride];
+			if (up) relax(index - stride, kStepValue);
+			if (left) relax(index - 1, kStepValue);
+			if (right) relax(index + 1, kStepValue);
+			if (down) relax(index + stride, kStepValue);
+			if (corner_)
+			{
+				// same corner rule as MyAStar: both straight neighbours must be passable
+				if (up && left && open[index - stride - 1]) relax(index - stride - 1, kObliqueValue);
+				if (up && right && open[index - stride + 1]) relax(index - stride + 1, kObliqueValue);
+				if (down && left && open[index + stride - 1]) relax(index + stride - 1, kObliqueValue);
+				if (down && right && open[index + stride + 1]) relax(index + stride + 1, kObliqueValue);
+			}
+		}
+	}
+}
+
+void MyHpaGraph::connect(const MyMap& map, const MyPoint& pos, const MyPoint& target, std::vector<std::pair<int, int>>* out) const
+{
+	const int cluster = cluster_of(pos.x(), pos.y());
+	Area area;
+	load(map, cluster, &area);
+
+	std::vector<int> cost;
+	flood(&area, pos.x(), pos.y(), &cost);
+
+	for (const int node : clusters_[cluster]->nodes)
+	{
+		const int c = cost[area.index(node % width_, node / width_)];
+		if (c >= 0)
+			out->emplace_back(node, c);
+	}
+
+	// the straight way inside a shared cluster competes with every detour
+	if (cluster == cluster_of(target.x(), target.y()))
+	{
+		const int c = cost[area.index(target.x(), target.y())];
+		if (c >= 0)
+			out->emplace_back(target.y() * width_ + target.x(), c);
+	}
+}
+
+bool MyHpaGraph::find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* waypoints) const
+{
+	const MyPoint& start = param.start;
+	const MyPoint& end = param.end;
+	if ((param.corner != corner_) || (map.width != width_) || (map.height != height_)
+		|| !map.contains(start.x(), start.y()) || !map.contains(end.x(), end.y())
+		|| !map.is_road(start.x(), start.y()) || !map.is_road(end.x(), end.y()))
+	{
+		return false;
+	}
+
+	waypoints->clear();
+	if (start == end)
+	{
+		waypoints->push_back(start);
+		return true;
+	}
+
+	// temporary edges of the start and goal to the entrances of their clusters
+	std::vector<std::pair<int, int>> from_start;
+	std::vector<std::pair<int, int>> to_end;
+	connect(map, start, end, &from_start);
+	connect(map, end, end, &to_end);
+
+	const int end_cluster = cluster_of(end.x(), end.y());
+	const int end_index = end.y() * width_ + end.x();
+
+	context->begin(width_, height_);
+	MyIndexedHeap<Node, MyNodeLess>& open_list = context->open_list();
+	open_list.clear();
+
+	auto relax = [context, &open_list, &end, this](Node* current, const int index, const int cost)
+	{
+		Node* next = context->node(index);
+		const int g = current->g + cost;
+		if (nullptr == next)
+		{
+			next = context->create(MyPoint{ index % width_, index / width_ });
+			next->g = g;
+			next->h = my_hpa_estimate(next->pos, end, corner_);
+			next->parent = current;
+			next->state = IN_OPENLIST;
+			open_list.push(next);
+		}
+		else if ((IN_OPENLIST == next->state) && (g < next->g))
+		{
+			next->g = g;
+			next->parent = current;
+			open_list.decrease(next);
+		}
+	};
+
+	Node* start_node = context->create(start);
+	start_node->h = my_hpa_estimate(start, end, corner_);
+	start_node->state = IN_OPENLIST;
+	open_list.push(start_node);
+
+	while (!open_list.empty())
+	{
+		Node* current = open_list.pop();
+		current->state = IN_CLOSEDLIST;
+
+		if (current->pos == end)
+		{
+			while (current)
+			{
+				waypoints->push_back(current->pos);
+				current = current->parent;
+			}
+			std::ranges::reverse(*waypoints);
+			open_list.clear();
+			return true;
+		}
+
+		if (current == start_node)
+		{
+			for (const auto& it : from_start)
+				relax(current, it.first, it.second);
+		}
+
+		const int index = current->pos.y() * width_ + current->pos.x();
+		const int cluster = cluster_of(current->pos.x(), current->pos.y());
+		const Cluster& data = *clusters_[cluster];
+		auto found = std::ranges::lower_bound(data.nodes, index);
+		if ((found == data.nodes.end()) || (*found != index))
+			continue;
+
+		// edges inside the cluster
+		const int n = static_cast<int>(data.nodes.size());
+		const int* row = data.dist.data() + (found - data.nodes.begin()) * n;
+		for (int i = 0; i < n; ++i)
+		{
+			if (row[i] > 0)
+				relax(current, data.nodes[i], row[i]);
+		}
+
+		// edges across the borders
+		for (const auto& it : data.east)
+		{
+			if (it.first == index)
+				relax(current, it.second, kStepValue);
+		}
+		for (const auto& it : data.south)
+		{
+			if (it.first == index)
+				relax(current, it.second, kStepValue);
+		}
+		if (cluster % columns_)
+		{
+			for (const auto& it : clusters_[cluster - 1]->east)
+			{
+				if (it.second == index)
+					relax(current, it.first, kStepValue);
+			}
+		}
+		if (cluster >= columns_)
+		{
+			for (const auto& it : clusters_[cluster - columns_]->south)
+			{
+				if (it.second == index)
+					relax(current, it.first, kStepValue);
+			}
+		}
+
+		// edge to the goal
+		if (cluster == end_cluster)
+		{
+			for (const auto& it : to_end)
+			{
+				if (it.first == index)
+					relax(current, end_index, it.second);
+			}
+		}
+	}
+
+	open_list.clear();
+	return false;
+}
+
+bool MyHpaGraph::refine(MySearchContext* context, const MyMap& map, const MyPoint& a, const MyPoint& b, std::vector<MyPoint>* path) const
+{
+	if ((map.width != width_) || (map.height != height_)
+		|| !map.contains(a.x(), a.y()) || !map.contains(b.x(), b.y()))
+	{
+		return false;
+	}
+
+	const int cluster = cluster_of(a.x(), a.y());
+	if (cluster != cluster_of(b.x(), b.y()))
+	{
+		// a transition, one straight step across the border
+		if (((b - a).manhattanLength() != 1) || !map.is_road(b.x(), b.y()))
+			return false;
+
+		path->push_back(b);
+		return true;
+	}
+
+	// the search is kept inside the cluster, just like the precomputed costs
+	const MyRectPass can_pass = bounds(map, cluster);
+	const MyParams param(width_, height_, corner_, a, b, nullptr);
+	std::vector<MyPoint> segment;
+	bool bret = false;
+	if (corner_)
+	{
+		MyAStar<MyRectPass, true> astar(context, can_pass);
+		bret = astar.find(param, &segment);
+	}
+	else
+	{
+		MyAStar<MyRectPass, false> astar(context, can_pass);
+		bret = astar.find(param, &segment);
+	}
+
+	if (bret)
+		path->insert(path->end(), segment.begin(), segment.end());
+	return bret;
+}
+
+bool my_hpa_find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path)
+{
+	// the graph only links road cells, a start on a wall runs on A* too, which lets it step off the wall
+	const MyHpaGraph* graph = map.hierarchy.get();
+	if ((nullptr == graph) || (graph->corner() != param.corner)
+		|| (map.contains(param.start.x(), param.start.y()) && !map.is_road(param.start.x(), param.start.y())))
+	{
+		return my_astar_find(context, map, param, path);
+	}
+
+	std::vector<MyPoint> waypoints;
+	if (!graph->find(context, map, param, &waypoints))
+	{
+		return false;
+	}
+
+	const size_t size = waypoints.size();
+	for (size_t i = 1; i < size; ++i)
+	{
+		if (!graph->refine(context, map, waypoints[i - 1], waypoints[i], path))
+		{
+			path->clear();
+			return false;
+		}
+	}
+	return true;
+}
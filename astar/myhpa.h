@@ -0,0 +1,123 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYHPA_H
+#define MYHPA_H
+#pragma execution_character_set("utf-8")
+#include "myastar.h"
+#include "mythreadpool.h"
+
+// HPA*: the map is cut into square clusters, the free cells facing each other across a
+// cluster border form entrances and the costs between the entrances of a cluster are
+// precomputed, so a long query searches the small abstract graph first and only refines
+// the chosen segments on the grid, every segment stays inside one cluster or crosses one border
+// the result is close to optimal but not guaranteed optimal
+class MyHpaGraph
+{
+	MY_DISABLE_COPY_MOVE(MyHpaGraph)
+public:
+	static constexpr int kDefaultClusterSize = 32;
+
+	// data of one cluster, shared between graph versions until the cluster is rebuilt
+	struct Cluster
+	{
+		std::vector<std::pair<int, int>> east;  // transitions to the east neighbour (cell here, cell there)
+		std::vector<std::pair<int, int>> south; // transitions to the south neighbour (cell here, cell there)
+		std::vector<int> nodes;                 // entrance cells inside this cluster
+		std::vector<int> dist;                  // nodes x nodes costs inside the cluster, -1 if unreachable
+	};
+
+	explicit MyHpaGraph() = default;
+
+	virtual ~MyHpaGraph() = default;
+
+	// build the graph of the map for the connectivity, nullptr if the cluster size is invalid
+	MY_REQUIRED_RESULT static std::shared_ptr<const MyHpaGraph> __vectorcall build(const MyMap& map, const int cluster_size, const bool corner);
+
+	// build the graph of an edited map from the graph of the previous version,
+	// only the clusters touching the changed rectangles are rebuilt, the rest are shared
+	MY_REQUIRED_RESULT static std::shared_ptr<const MyHpaGraph> __vectorcall update(const MyHpaGraph& base, const MyMap& map, const std::vector<MyRect>& changed);
+
+	MY_REQUIRED_RESULT __forceinline int cluster_size() const { return size_; }
+
+	MY_REQUIRED_RESULT __forceinline bool corner() const { return corner_; }
+
+	// search the abstract graph, the waypoints start with param.start and end with param.end
+	MY_REQUIRED_RESULT bool __vectorcall find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* waypoints) const;
+
+	// append the cells from a to b excluding a, a and b are consecutive waypoints of find
+	MY_REQUIRED_RESULT bool __vectorcall refine(MySearchContext* context, const MyMap& map, const MyPoint& a, const MyPoint& b, std::vector<MyPoint>* path) const;
+
+private:
+	int width_ = 0;
+	int height_ = 0;
+	int size_ = 0;
+	int columns_ = 0;                       // clusters per row
+	int rows_ = 0;                          // clusters per column
+	bool corner_ = true;
+	std::vector<std::shared_ptr<const Cluster>> clusters_;
+
+	// index of the cluster containing the cell
+	MY_REQUIRED_RESULT __forceinline int __vectorcall cluster_of(const int x, const int y) const
+	{
+		return (y / size_) * columns_ + (x / size_);
+	}
+
+	// passability of one cluster surrounded by a one cell wall, so a flood needs no bounds checks
+	struct Area
+	{
+		static constexpr int kBuckets = 15;  // a step costs at most 14
+
+		int left = 0;
+		int top = 0;
+		int stride = 0;                     // cluster width + 2
+		std::vector<uint8_t> open;
+		std::vector<int> buckets[kBuckets];  // reused by every flood of the area
+
+		MY_REQUIRED_RESULT __forceinline int __vectorcall index(const int x, const int y) const
+		{
+			return (y - top + 1) * stride + (x - left + 1);
+		}
+	};
+
+	// the cells of the cluster
+	MY_REQUIRED_RESULT MyRectPass __vectorcall bounds(const MyMap& map, const int cluster) const;
+
+	// copy the passability of the cluster
+	void __vectorcall load(const MyMap& map, const int cluster, Area* out) const;
+
+	// find the transitions on the east and south borders of the cluster
+	void __vectorcall build_borders(const MyMap& map, const int cluster, Cluster* out) const;
+
+	// collect the entrance cells of the cluster and the costs between them, the borders of
+	// the cluster and of its west and north neighbours must be built already
+	void __vectorcall build_nodes(const MyMap& map, const int cluster, Cluster* out) const;
+
+	// the entrances of the cluster with the cost of reaching each of them from the cell,
+	// plus the target if it is in the same cluster and reachable inside it
+	void __vectorcall connect(const MyMap& map, const MyPoint& pos, const MyPoint& target, std::vector<std::pair<int, int>>* out) const;
+
+	// costs from the cell to every cell of the area (Area::index), -1 if unreachable
+	void __vectorcall flood(Area* area, const int x, const int y, std::vector<int>* cost) const;
+};
+
+// search the hierarchy of the map and refine the whole path,
+// plain A* if the map has no hierarchy for the connectivity of param.corner or the start is on a wall
+MY_REQUIRED_RESULT bool __vectorcall my_hpa_find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path);
+
+#endif
@@ -0,0 +1,412 @@
+﻿#include "myjps.h"
+
+constexpr int kStepValue = 10;
+constexpr int kObliqueValue = 14;
+
+std::shared_ptr<const MyJumpTable> MyJumpTable::build(const MyMap& map)
+{
+	const int w = map.width;
+	const int h = map.height;
+	if ((w <= 0) || (h <= 0) || (w > SHRT_MAX) || (h > SHRT_MAX))
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<MyJumpTable> table = std::make_shared<MyJumpTable>();
+	table->width_ = w;
+	table->height_ = h;
+	table->dist_.assign(static_cast<size_t>(w) * h * 8, 0);
+
+	auto can_pass = [&map](const int x, const int y)->bool
+	{
+		return map.contains(x, y) && map.is_road(x, y);
+	};
+
+	auto slot = [&table, w](const int x, const int y, const int dir)->int16_t&
+	{
+		return table->dist_[((static_cast<size_t>(y) * w + x) << 3) + dir];
+	};
+
+	// the same forced neighbour rule as MyJps::jump for a straight move into (x, y)
+	auto forced = [&can_pass](const int x, const int y, const int dx, const int dy)->bool
+	{
+		if (dx)
+		{
+			return (can_pass(x, y - 1) && !can_pass(x - dx, y - 1)) ||
+				(can_pass(x, y + 1) && !can_pass(x - dx, y + 1));
+		}
+		return (can_pass(x - 1, y) && !can_pass(x - 1, y - dy)) ||
+			(can_pass(x + 1, y) && !can_pass(x + 1, y - dy));
+	};
+
+	// visit the cells so that (x + dx, y + dy) is always done before (x, y)
+	auto sweep = [w, h](const int dx, const int dy, auto&& visit)
+	{
+		for (int i = 0; i < h; ++i)
+		{
+			const int y = (dy > 0) ? (h - 1 - i) : i;
+			for (int j = 0; j < w; ++j)
+			{
+				visit((dx > 0) ? (w - 1 - j) : j, y);
+			}
+		}
+	};
+
+	constexpr int kStraight[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+	for (const auto& d : kStraight)
+	{
+		const int dx = d[0];
+		const int dy = d[1];
+		const int dir = direction(dx, dy);
+		sweep(dx, dy, [&](const int x, const int y)
+			{
+				const int nx = x + dx;
+				const int ny = y + dy;
+				int16_t value = 0;
+				if (!can_pass(nx, ny))
+					value = 0;
+				else if (forced(nx, ny, dx, dy))
+					value = 1;
+				else
+				{
+					const int16_t next = slot(nx, ny, dir);
+					value = (next > 0) ? (next + 1) : (next - 1);
+				}
+				slot(x, y, dir) = value;
+			});
+	}
+
+	// a diagonal step is a jump point if one of its straight distances finds one
+	constexpr int kDiagonal[4][2] = { { 1, -1 }, { 1, 1 }, { -1, 1 }, { -1, -1 } };
+	for (const auto& d : kDiagonal)
+	{
+		const int dx = d[0];
+		const int dy = d[1];
+		const int dir = direction(dx, dy);
+		const int horizontal = direction(dx, 0);
+		const int vertical = direction(0, dy);
+		sweep(dx, dy, [&](const int x, const int y)
+			{
+				const int nx = x + dx;
+				const int ny = y + dy;
+				int16_t value = 0;
+				if (!can_pass(nx, ny) || !can_pass(nx, y) || !can_pass(x, ny))
+					value = 0;
+				else if ((slot(nx, ny, horizontal) > 0) || (slot(nx, ny, vertical) > 0))
+					value = 1;
+				else
+				{
+					const int16_t next = slot(nx, ny, dir);
+					value = (next > 0) ? (next + 1) : (next - 1);
+				}
+				slot(x, y, dir) = value;
+			});
+	}
+
+	return table;
+}
+
+template <typename Passable>
+MyJps<Passable>::MyJps(MySearchContext* context, const Passable& can_pass, const MyJumpTable* table)
+	: can_pass_(can_pass)
+	, context_(context)
+	, table_(table)
+	, open_list_(context->open_list())
+	, step_val_(kStepValue)
+	, oblique_val_(kObliqueValue)
+{
+}
+
+template <typename Passable>
+__forceinline bool MyJps<Passable>::can_pass(const int x, const int y) const
+{
+	return ((x >= 0) && (x < width_) && (y >= 0) && (y < height_)) ? can_pass_(x, y) : false;
+}
+
+template <typename Passable>
+__forceinline int MyJps<Passable>::distance(const MyPoint& a, const MyPoint& b) const
+{
+	const int dx = abs(a.x() - b.x());
+	const int dy = abs(a.y() - b.y());
+	return (dx < dy) ? (oblique_val_ * dx + step_val_ * (dy - dx)) : (oblique_val_ * dy + step_val_ * (dx - dy));
+}
+
+template <typename Passable>
+bool MyJps<Passable>::jump(int x, int y, const int dx, const int dy, MyPoint* out) const
+{
+	for (;;)
+	{
+		x += dx;
+		y += dy;
+
+		if (!can_pass(x, y))
+			return false;
+
+		if ((x == end_.x()) && (y == end_.y()))
+			break;
+
+		if (dx && dy)
+		{
+			// a diagonal step is a jump point if one of its straight scans finds something
+			if (jump(x, y, dx, 0, nullptr) || jump(x, y, 0, dy, nullptr))
+				break;
+
+			// the next diagonal step must not cut a corner
+			if (!can_pass(x + dx, y) || !can_pass(x, y + dy))
+				return false;
+		}
+		else if (dx)
+		{
+			// forced neighbour: the cell beside us is open but was blocked beside the previous cell
+			if ((can_pass(x, y - 1) && !can_pass(x - dx, y - 1)) ||
+				(can_pass(x, y + 1) && !can_pass(x - dx, y + 1)))
+				break;
+		}
+		else
+		{
+			if ((can_pass(x - 1, y) && !can_pass(x - 1, y - dy)) ||
+				(can_pass(x + 1, y) && !can_pass(x + 1, y - dy)))
+				break;
+		}
+	}
+
+	if (nullptr != out)
+		out->reset(x, y);
+	return true;
+}
+
+template <typename Passable>
+bool MyJps<Passable>::jump_table(const int x, const int y, const int dx, const int dy, MyPoint* out) const
+{
+	const int value = table_->at(x, y, MyJumpTable::direction(dx, dy));
+	const int reach = (value > 0) ? value : -value;
+
+	// the nearest step that is a jump point, the end point or sees the end point
+	int steps = (value > 0) ? value : INT_MAX;
+	const int ex = (end_.x() - x) * dx;
+	const int ey = (end_.y() - y) * dy;
+
+	if (dx && dy)
+	{
+		if ((ex == ey) && (ex >= 1) && (ex <= reach))
+		{
+			steps = (std::min)(steps, ex);
+		}
+
+		// crossing the row of the end point, a horizontal scan from there may reach it
+		if ((ey >= 1) && (ey <= reach) && (ey < steps))
+		{
+			const int cx = x + dx * ey;
+			const int run = (end_.x() - cx) * dx;
+			const int free_run = abs(table_->at(cx, end_.y(), MyJumpTable::direction(dx, 0)));
+			if ((run >= 1) && (run <= free_run))
+				steps = ey;
+		}
+
+		// crossing the column of the end point
+		if ((ex >= 1) && (ex <= reach) && (ex < steps))
+		{
+			const int cy = y + dy * ex;
+			const int run = (end_.y() - cy) * dy;
+			const int free_run = abs(table_->at(end_.x(), cy, MyJumpTable::direction(0, dy)));
+			if ((run >= 1) && (run <= free_run))
+				steps = ex;
+		}
+	}
+	else if (dx)
+	{
+		if ((end_.y() == y) && (ex >= 1) && (ex <= reach))
+			steps = ex;
+	}
+	else
+	{
+		if ((end_.x() == x) && (ey >= 1) && (ey <= reach))
+			steps = ey;
+	}
+
+	if (INT_MAX == steps)
+		return false;
+
+	out->reset(x + dx * steps, y + dy * steps);
+	return true;
+}
+
+template <typename Passable>
+int MyJps<Passable>::find_directions(const Node* node, int (*out_dirs)[2]) const
+{
+	const int x = node->pos.x();
+	const int y = node->pos.y();
+	int count = 0;
+
+	auto push = [&count, out_dirs](const bool passable, const int dx, const int dy)
+	{
+		if (passable)
+		{
+			out_dirs[count][0] = dx;
+			out_dirs[count][1] = dy;
+			++count;
+		}
+	};
+
+	if (nullptr == node->parent)
+	{
+		// the start node searches every legal direction
+		const bool up = can_pass(x, y - 1);
+		const bool left = can_pass(x - 1, y);
+		const bool right = can_pass(x + 1, y);
+		const bool down = can_pass(x, y + 1);
+		push(up, 0, -1);
+		push(left, -1, 0);
+		push(right, 1, 0);
+		push(down, 0, 1);
+		push(up && left && can_pass(x - 1, y - 1), -1, -1);
+		push(up && right && can_pass(x + 1, y - 1), 1, -1);
+		push(down && left && can_pass(x - 1, y + 1), -1, 1);
+		push(down && right && can_pass(x + 1, y + 1), 1, 1);
+		return count;
+	}
+
+	const int dx = (x > node->parent->pos.x()) - (x < node->parent->pos.x());
+	const int dy = (y > node->parent->pos.y()) - (y < node->parent->pos.y());
+
+	if (dx && dy)
+	{
+		const bool vertical = can_pass(x, y + dy);
+		const bool horizontal = can_pass(x + dx, y);
+		push(vertical, 0, dy);
+		push(horizontal, dx, 0);
+		push(vertical && horizontal && can_pass(x + dx, y + dy), dx, dy);
+	}
+	else if (dx)
+	{
+		const bool next = can_pass(x + dx, y);
+		const bool up = can_pass(x, y - 1);
+		const bool down = can_pass(x, y + 1);
+		push(next, dx, 0);
+		push(next && up && can_pass(x + dx, y - 1), dx, -1);
+		push(next && down && can_pass(x + dx, y + 1), dx, 1);
+		push(up, 0, -1);
+		push(down, 0, 1);
+	}
+	else
+	{
+		const bool next = can_pass(x, y + dy);
+		const bool left = can_pass(x - 1, y);
+		const bool right = can_pass(x + 1, y);
+		push(next, 0, dy);
+		push(next && left && can_pass(x - 1, y + dy), -1, dy);
+		push(next && right && can_pass(x + 1, y + dy), 1, dy);
+		push(left, -1, 0);
+		push(right, 1, 0);
+	}
+	return count;
+}
+
+template <typename Passable>
+void MyJps<Passable>::build_path(const Node* node, std::vector<MyPoint>* path) const
+{
+	while (node->parent)
+	{
+		const MyPoint& from = node->parent->pos;
+		const int dx = (node->pos.x() > from.x()) - (node->pos.x() < from.x());
+		const int dy = (node->pos.y() > from.y()) - (node->pos.y() < from.y());
+
+		// every jump is a straight or diagonal line, emit it backwards down to the cell after the parent
+		int x = node->pos.x();
+		int y = node->pos.y();
+		while ((x != from.x()) || (y != from.y()))
+		{
+			path->push_back(MyPoint{ x, y });
+			x -= dx;
+			y -= dy;
+		}
+		node = node->parent;
+	}
+	std::ranges::reverse(*path);
+}
+
+template <typename Passable>
+bool MyJps<Passable>::find(const MyParams& param, std::vector<MyPoint>* path)
+{
+	if (!(param.corner)
+		|| ((param.width) <= 0) || ((param.height) <= 0)
+		|| ((param.start.x()) < 0) || ((param.start.x()) >= (param.width))
+		|| ((param.start.y()) < 0) || ((param.start.y()) >= (param.height))
+		|| ((param.end.x()) < 0) || ((param.end.x()) >= (param.width))
+		|| ((param.end.y()) < 0) || ((param.end.y()) >= (param.height)))
+	{
+		return false;
+	}
+
+	width_ = param.width;
+	height_ = param.height;
+	end_ = param.end;
+	context_->begin(width_, height_);
+
+	Node* start_node = context_->create(param.start);
+	start_node->h = distance(param.start, end_);
+	start_node->state = IN_OPENLIST;
+	open_list_.push(start_node);
+
+	int dirs[8][2] = {};
+	MyPoint jump_point = {};
+
+	while (!open_list_.empty())
+	{
+		Node* current = open_list_.pop();
+		current->state = IN_CLOSEDLIST;
+
+		if ((current->pos) == end_)
+		{
+			build_path(current, path);
+			open_list_.clear();
+			return true;
+		}
+
+		const int count = find_directions(current, dirs);
+		for (int i = 0; i < count; ++i)
+		{
+			const bool found = (nullptr != table_) ?
+				jump_table(current->pos.x(), current->pos.y(), dirs[i][0], dirs[i][1], &jump_point) :
+				jump(current->pos.x(), current->pos.y(), dirs[i][0], dirs[i][1], &jump_point);
+			if (!found)
+				continue;
+
+			const int g_value = current->g + distance(current->pos, jump_point);
+			Node* next_node = context_->node(jump_point.y() * width_ + jump_point.x());
+			if (nullptr == next_node)
+			{
+				next_node = context_->create(jump_point);
+				next_node->g = g_value;
+				next_node->h = distance(jump_point, end_);
+				next_node->parent = current;
+				next_node->state = IN_OPENLIST;
+				open_list_.push(next_node);
+			}
+			else if ((IN_OPENLIST == next_node->state) && (g_value < next_node->g))
+			{
+				next_node->g = g_value;
+				next_node->parent = current;
+				open_list_.decrease(next_node);
+			}
+		}
+	}
+
+	open_list_.clear();
+	return false;
+}
+
+template class MyJps<MyGridPass>;
+template class MyJps<MyCallbackPass>;
+
+
+bool my_jps_find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path)
+{
+	if (!param.corner)
+	{
+		return my_astar_find(context, map, param, path);
+	}
+
+	MyJps<MyGridPass> jps(context, MyGridPass{ &map }, map.jump_table.get());
+	return jps.find(param, path);
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYJPS_H
+#define MYJPS_H
+#pragma execution_character_set("utf-8")
+#include "myastar.h"
+
+// JPS+ preprocessing: for every cell and each of the 8 directions the distance to the next
+// jump point or wall, so a query replaces every scan of MyJps by a single lookup
+// the goal of a query is not known in advance, MyJps checks it against the stored distances
+class MyJumpTable
+{
+	MY_DISABLE_COPY_MOVE(MyJumpTable)
+public:
+	explicit MyJumpTable() = default;
+
+	virtual ~MyJumpTable() = default;
+
+	// build the table for the map, nullptr if a side is too long for 16-bit distances
+	MY_REQUIRED_RESULT static std::shared_ptr<const MyJumpTable> __vectorcall build(const MyMap& map);
+
+	// index of the direction (dx, dy) in the table
+	MY_REQUIRED_RESULT static __forceinline int __vectorcall direction(const int dx, const int dy)
+	{
+		constexpr int kDirections[9] = { 7, 0, 1, 6, -1, 2, 5, 4, 3 };
+		return kDirections[(dy + 1) * 3 + (dx + 1)];
+	}
+
+	// > 0: a jump point that many steps away
+	// <= 0: no jump point, minus the number of free steps before a wall
+	MY_REQUIRED_RESULT __forceinline int __vectorcall at(const int x, const int y, const int dir) const
+	{
+		return dist_[((static_cast<size_t>(y) * width_ + x) << 3) + dir];
+	}
+
+private:
+	int width_ = 0;
+	int height_ = 0;
+	std::vector<int16_t> dist_;             // 8 directions per cell, row-major
+};
+
+// Jump Point Search for uniform-cost 8-dir grids
+// diagonal moves follow the same corner rule as MyAStar: both straight neighbours must be passable
+// only jump points are put in the open list, the returned path is expanded back to cell by cell
+template <typename Passable>
+class MyJps
+{
+public:
+	// scans the map unless a jump table built for the same map is given
+	explicit MyJps(MySearchContext* context, const Passable& can_pass, const MyJumpTable* table = nullptr);
+
+	virtual ~MyJps() = default;
+
+	// execute the pathfinding operation, param.corner must be true
+	MY_REQUIRED_RESULT bool __vectorcall find(const MyParams& param, std::vector<MyPoint>* path);
+
+private:
+	int                step_val_ = 10;
+	int                oblique_val_ = 14;
+	int                height_ = 0;
+	int                width_ = 0;
+	MyPoint            end_ = {};
+	Passable           can_pass_ = {};
+	MySearchContext* context_ = nullptr;
+	const MyJumpTable* table_ = nullptr;
+	MyIndexedHeap<Node, MyNodeLess>& open_list_;
+
+	// check the point is inside the map and passable
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall can_pass(const int x, const int y) const;
+
+	// octile distance between two points
+	MY_REQUIRED_RESULT __forceinline int __vectorcall distance(const MyPoint& a, const MyPoint& b) const;
+
+	// walk from (x, y) in direction (dx, dy) until a jump point, the end point or a wall
+	// the first step must already be known to be legal
+	MY_REQUIRED_RESULT bool __vectorcall jump(int x, int y, const int dx, const int dy, MyPoint* out) const;
+
+	// same as jump with the distances read from the jump table
+	MY_REQUIRED_RESULT bool __vectorcall jump_table(const int x, const int y, const int dx, const int dy, MyPoint* out) const;
+
+	// get the pruned directions to search from the node
+	MY_REQUIRED_RESULT int __vectorcall find_directions(const Node* node, int (*out_dirs)[2]) const;
+
+	// walk the parent chain and expand every jump to the cells in between
+	void __vectorcall build_path(const Node* node, std::vector<MyPoint>* path) const;
+};
+
+// run Jump Point Search over a built-in grid map, falls back to MyAStar for 4-dir searches
+// uses the JPS+ table of the map when it has one
+MY_REQUIRED_RESULT bool __vectorcall my_jps_find(MySearchContext* context, const MyMap& map, const MyParams& param, std::vector<MyPoint>* path);
+
+#endif
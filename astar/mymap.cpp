@@ -0,0 +1,265 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mymap.h"
+
+// target chunk size in 64-bit words (8 KB)
+constexpr int kChunkWords = 1024;
+
+int MyMap::test(const MyPoint* points, const int count, const OBJECTTYPE type, uint8_t* bits) const
+{
+	if ((count <= 0) || (width <= 0) || (height <= 0))
+	{
+		if (count > 0)
+			memset(bits, 0, (static_cast<size_t>(count) + 7) >> 3);
+		return 0;
+	}
+
+	// a collision is a 0 bit, flipping the cell bit keeps the loop free of branches on the type
+	const uint64_t flip = (TYPE_COLLISION == type) ? 1ULL : 0ULL;
+	const uint32_t w = static_cast<uint32_t>(width);
+	const uint32_t h = static_cast<uint32_t>(height);
+	int total = 0;
+	for (int first = 0; first < count; first += 64)
+	{
+		const int n = (std::min)(64, count - first);
+		const MyPoint* p = points + first;
+		uint64_t word = 0;
+		for (int i = 0; i < n; ++i)
+		{
+			// a point outside reads cell (0, 0) and is masked off, so the loads do not wait on a branch
+			const uint64_t inside = (static_cast<uint32_t>(p[i].x()) < w) & (static_cast<uint32_t>(p[i].y()) < h);
+			const int x = inside ? p[i].x() : 0;
+			const int y = inside ? p[i].y() : 0;
+			const uint64_t cell = (row(y)[x >> 6] >> (x & 63)) & 1ULL;
+			word |= ((cell ^ flip) & inside) << i;
+		}
+
+		// the low bytes of the word are the next bytes of the mask
+		memcpy(bits + (first >> 3), &word, (static_cast<size_t>(n) + 7) >> 3);
+		total += std::popcount(word);
+	}
+	return total;
+}
+
+MyMapEditor::MyMapEditor(const int w, const int h, const OBJECTTYPE type)
+	: map_(std::make_shared<MyMap>())
+{
+	map_->width = w;
+	map_->height = h;
+	map_->stride = (w + 63) >> 6;
+
+	int shift = 0;
+	while (((map_->stride) << (shift + 1)) <= kChunkWords)
+		++shift;
+	map_->chunk_shift = shift;
+
+	const size_t count = ((static_cast<size_t>(h) - 1) >> shift) + 1;
+	const size_t words = map_->chunk_words();
+
+	// every chunk starts out identical, so they all share a single block
+	std::shared_ptr<uint64_t[]> fill = std::make_shared<uint64_t[]>(words);
+	if (TYPE_ROAD == type)
+	{
+		const int rows = 1 << shift;
+		const uint64_t tail = (w & 63) ? ((1ULL << (w & 63)) - 1ULL) : ~0ULL;
+		for (int r = 0; r < rows; ++r)
+		{
+			uint64_t* p = fill.get() + static_cast<size_t>(r) * map_->stride;
+			std::fill_n(p, map_->stride, ~0ULL);
+			p[map_->stride - 1] = tail;
+		}
+	}
+
+	map_->chunks.assign(count, fill);
+	writable_.assign(count, nullptr);
+}
+
+MyMapEditor::MyMapEditor(const MyMap& base)
+	: map_(std::make_shared<MyMap>(base))
+	, writable_(base.chunks.size(), nullptr)
+{
+	// derived tables describe the old cells, the next version has to rebuild them
+	map_->jump_table = nullptr;
+	map_->hierarchy = nullptr;
+	map_->components = nullptr;
+}
+
+uint64_t* MyMapEditor::mutable_row(const int y)
+{
+	const size_t index = static_cast<size_t>(y >> map_->chunk_shift);
+	uint64_t*& chunk = writable_[index];
+	if (nullptr == chunk)
+	{
+		const size_t words = map_->chunk_words();
+		std::shared_ptr<uint64_t[]> copy(new uint64_t[words]);
+		memcpy(copy.get(), map_->chunks[index].get(), words * sizeof(uint64_t));
+		chunk = copy.get();
+		map_->chunks[index] = std::move(copy);
+	}
+	return chunk + static_cast<size_t>(y & ((1 << map_->chunk_shift) - 1)) * map_->stride;
+}
+
+bool MyMapEditor::set(const int x, const int y, const OBJECTTYPE type)
+{
+	if (map_->at(x, y) == type)
+		return false;
+
+	uint64_t& word = mutable_row(y)[x >> 6];
+	word ^= 1ULL << (x & 63);
+	return true;
+}
+
+// clip the rectangle to the map, return false if nothing is left
+static bool clip(const MyMap& map, const MyRect& rect, int* x0, int* y0, int* x1, int* y1)
+{
+	*x0 = (std::max)(rect.x, 0);
+	*y0 = (std::max)(rect.y, 0);
+	*x1 = static_cast<int>((std::min)(static_cast<int64_t>(rect.x) + rect.w, static_cast<int64_t>(map.width)));
+	*y1 = static_cast<int>((std::min)(static_cast<int64_t>(rect.y) + rect.h, static_cast<int64_t>(map.height)));
+	return (*x0 < *x1) && (*y0 < *y1);
+}
+
+// mask of the bits of word w that lie in the columns [x0, x1)
+static __forceinline uint64_t column_mask(const int w, const int x0, const int x1)
+{
+	uint64_t mask = ~0ULL;
+	if (w == (x0 >> 6))
+		mask &= ~0ULL << (x0 & 63);
+	if (w == ((x1 - 1) >> 6))
+		mask &= ~0ULL >> (63 - ((x1 - 1) & 63));
+	return mask;
+}
+
+// 64 bits of a mask row starting at the bit, bits before the row start are 0
+static __forceinline uint64_t load_bits(const uint8_t* row, const size_t bytes, const int64_t bit)
+{
+	if (bit < 0)
+		return load_bits(row, bytes, 0) << (-bit);
+
+	const size_t offset = static_cast<size_t>(bit >> 3);
+	const int shift = static_cast<int>(bit & 7);
+
+	uint64_t value = 0;
+	memcpy(&value, row + offset, (std::min)(bytes - offset, sizeof(value)));
+	value >>= shift;
+	if ((shift != 0) && ((offset + sizeof(value)) < bytes))
+		value |= static_cast<uint64_t>(row[offset + sizeof(value)]) << (64 - shift);
+	return value;
+}
+
+int MyMapEditor::fill(const MyRect& rect, const OBJECTTYPE type)
+{
+	int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+	if (!clip(*map_, rect, &x0, &y0, &x1, &y1))
+		return 0;
+
+	const bool road = (TYPE_ROAD == type);
+	const int first = x0 >> 6;
+	const int last = (x1 - 1) >> 6;
+	const uint64_t head = column_mask(first, x0, x1);
+	const uint64_t tail = column_mask(last, x0, x1);
+
+	int changed = 0;
+	int w = 0;
+	for (int y = y0; y < y1; ++y)
+	{
+		const uint64_t* src = map_->row(y);
+		int count = 0;
+		for (w = first; w <= last; ++w)
+		{
+			const uint64_t mask = (w == first) ? head : ((w == last) ? tail : ~0ULL);
+			count += std::popcount((road ? ~src[w] : src[w]) & mask);
+		}
+		if (0 == count)
+			continue;
+
+		uint64_t* dst = mutable_row(y);
+		if (first == last)
+		{
+			dst[first] = road ? (dst[first] | head) : (dst[first] & ~head);
+		}
+		else
+		{
+			dst[first] = road ? (dst[first] | head) : (dst[first] & ~head);
+			std::fill(dst + first + 1, dst + last, road ? ~0ULL : 0ULL);
+			dst[last] = road ? (dst[last] | tail) : (dst[last] & ~tail);
+		}
+		changed += count;
+	}
+	return changed;
+}
+
+int MyMapEditor::blit(const MyRect& rect, const uint8_t* bits, const size_t pitch)
+{
+	int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+	if ((nullptr == bits) || !clip(*map_, rect, &x0, &y0, &x1, &y1))
+		return 0;
+
+	const size_t bytes = (static_cast<size_t>(rect.w) + 7) >> 3;
+	const int first = x0 >> 6;
+	const int last = (x1 - 1) >> 6;
+
+	int changed = 0;
+	int w = 0;
+	for (int y = y0; y < y1; ++y)
+	{
+		const uint8_t* mask_row = bits + static_cast<size_t>(y - rect.y) * pitch;
+		const uint64_t* src = map_->row(y);
+		uint64_t* dst = nullptr;
+		for (w = first; w <= last; ++w)
+		{
+			// the mask marks collisions, the grid marks roads
+			const uint64_t mask = column_mask(w, x0, x1);
+			const uint64_t value = ~load_bits(mask_row, bytes, static_cast<int64_t>(w) * 64 - rect.x) & mask;
+			const uint64_t diff = (src[w] ^ value) & mask;
+			if (0 == diff)
+				continue;
+
+			if (nullptr == dst)
+			{
+				dst = mutable_row(y);
+				src = dst;
+			}
+			dst[w] ^= diff;
+			changed += std::popcount(diff);
+		}
+	}
+	return changed;
+}
+
+void MyMapEditor::attach(std::shared_ptr<const MyJumpTable> table)
+{
+	map_->jump_table = std::move(table);
+}
+
+void MyMapEditor::attach(std::shared_ptr<const MyHpaGraph> graph)
+{
+	map_->hierarchy = std::move(graph);
+}
+
+void MyMapEditor::attach(std::shared_ptr<const MyComponents> labels)
+{
+	map_->components = std::move(labels);
+}
+
+MyMapPtr MyMapEditor::publish(const uint64_t version)
+{
+	map_->version = version;
+	writable_.clear();
+	return std::exchange(map_, nullptr);
+}
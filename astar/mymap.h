@@ -0,0 +1,138 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYMAP_H
+#define MYMAP_H
+#include "mypoint.h"
+
+class MyJumpTable;
+class MyHpaGraph;
+class MyComponents;
+
+// immutable snapshot of a road/collision grid
+// cells are stored as a dense row-major bit grid, one bit per cell (1 = road, 0 = collision)
+// every row is padded to a whole 64-bit word and the padding bits are always 0
+// rows are grouped into chunks of (1 << chunk_shift) rows, chunks are shared between
+// versions of the same map and only the chunks touched by a writer are copied
+typedef struct tagMyMap
+{
+	using Chunk = std::shared_ptr<const uint64_t[]>;
+
+	int width = 0;
+	int height = 0;
+	int stride = 0;                         // 64-bit words per row
+	int chunk_shift = 0;                    // log2 of rows per chunk
+	uint64_t version = 0;                   // unique across all published maps
+	std::vector<Chunk> chunks = {};
+
+	// optional JPS+ table built for exactly this version, dropped by any edit
+	std::shared_ptr<const MyJumpTable> jump_table = nullptr;
+
+	// optional HPA* graph, edits rebuild only the clusters they touch
+	std::shared_ptr<const MyHpaGraph> hierarchy = nullptr;
+
+	// connected-component labels, kept up to date by every edit
+	std::shared_ptr<const MyComponents> components = nullptr;
+
+	// check the point is inside the map
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall contains(const int x, const int y) const
+	{
+		return (x >= 0) && (x < width) && (y >= 0) && (y < height);
+	}
+
+	// get the words of the specific row, the row must be inside the map
+	MY_REQUIRED_RESULT __forceinline const uint64_t* __vectorcall row(const int y) const
+	{
+		return chunks[y >> chunk_shift].get() + static_cast<size_t>(y & ((1 << chunk_shift) - 1)) * stride;
+	}
+
+	// check the point is passable, the point must be inside the map
+	MY_REQUIRED_RESULT __forceinline bool __vectorcall is_road(const int x, const int y) const
+	{
+		return (row(y)[x >> 6] >> (x & 63)) & 1ULL;
+	}
+
+	MY_REQUIRED_RESULT __forceinline OBJECTTYPE __vectorcall at(const int x, const int y) const
+	{
+		return is_road(x, y) ? TYPE_ROAD : TYPE_COLLISION;
+	}
+
+	// words per chunk
+	MY_REQUIRED_RESULT __forceinline size_t chunk_words() const
+	{
+		return static_cast<size_t>(stride) << chunk_shift;
+	}
+
+	// check many points at once, bit (i & 7) of bits[i >> 3] is set when points[i] is inside the map and of the type
+	// bits must hold (count + 7) / 8 bytes, return the number of set bits
+	int __vectorcall test(const MyPoint* points, const int count, const OBJECTTYPE type, uint8_t* bits) const;
+}MyMap;
+
+using MyMapPtr = std::shared_ptr<const MyMap>;
+
+// writer side of a map snapshot
+// starts from an existing version (or a filled grid) and clones a chunk on its first write
+class MyMapEditor
+{
+	MY_DISABLE_COPY_MOVE(MyMapEditor)
+public:
+	// start a brand-new map with every cell set to the specific type
+	explicit MyMapEditor(const int w, const int h, const OBJECTTYPE type);
+
+	// start from an existing version, nothing is copied until a chunk is written
+	explicit MyMapEditor(const MyMap& base);
+
+	virtual ~MyMapEditor() = default;
+
+	MY_REQUIRED_RESULT const MyMap& map() const { return *map_; }
+
+	// mark the point as road or collision, the point must be inside the map
+	// return true if the cell changed
+	bool __vectorcall set(const int x, const int y, const OBJECTTYPE type);
+
+	// set every cell of the rectangle to the type, parts outside the map are ignored
+	// rows are written a whole word at a time and rows that already hold the type are not copied
+	// return the number of cells that changed
+	int __vectorcall fill(const MyRect& rect, const OBJECTTYPE type);
+
+	// copy a bitmask onto the rectangle, parts outside the map are ignored
+	// the mask is row-major with pitch bytes per row, cell i of a row is bit (i & 7) of byte (i >> 3), 1 = collision
+	// return the number of cells that changed
+	int __vectorcall blit(const MyRect& rect, const uint8_t* bits, const size_t pitch);
+
+	// get the writable words of the specific row, the row must be inside the map
+	MY_REQUIRED_RESULT uint64_t* __vectorcall mutable_row(const int y);
+
+	// attach the JPS+ table built from map() to the version about to be published
+	void __vectorcall attach(std::shared_ptr<const MyJumpTable> table);
+
+	// attach the HPA* graph built from map() to the version about to be published
+	void __vectorcall attach(std::shared_ptr<const MyHpaGraph> graph);
+
+	// attach the component labels of map() to the version about to be published
+	void __vectorcall attach(std::shared_ptr<const MyComponents> labels);
+
+	// seal the edits and hand out the new immutable version, the editor must not be used afterwards
+	MY_REQUIRED_RESULT MyMapPtr __vectorcall publish(const uint64_t version);
+
+private:
+	std::shared_ptr<MyMap> map_;
+	std::vector<uint64_t*> writable_;       // chunks owned by this editor, nullptr if still shared
+};
+
+#endif
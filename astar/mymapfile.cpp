@@ -0,0 +1,185 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mymapfile.h"
+
+// read-only view of a whole file, unmapped with the last chunk pointing into it
+class MyMappedView
+{
+	MY_DISABLE_COPY_MOVE(MyMappedView)
+public:
+	explicit MyMappedView() = default;
+
+	virtual ~MyMappedView()
+	{
+		if (nullptr != data_)
+			UnmapViewOfFile(data_);
+		if (nullptr != mapping_)
+			CloseHandle(mapping_);
+		if (INVALID_HANDLE_VALUE != file_)
+			CloseHandle(file_);
+	}
+
+	MY_REQUIRED_RESULT bool __vectorcall open(const std::wstring& fileName)
+	{
+		file_ = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (INVALID_HANDLE_VALUE == file_)
+			return false;
+
+		LARGE_INTEGER size = {};
+		if (!GetFileSizeEx(file_, &size) || (size.QuadPart <= 0))
+			return false;
+
+		mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (nullptr == mapping_)
+			return false;
+
+		data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+		if (nullptr == data_)
+			return false;
+
+		size_ = static_cast<size_t>(size.QuadPart);
+		return true;
+	}
+
+	MY_REQUIRED_RESULT const uint8_t* data() const { return data_; }
+
+	MY_REQUIRED_RESULT size_t size() const { return size_; }
+
+private:
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+	HANDLE mapping_ = nullptr;
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+};
+
+uint64_t my_map_checksum(const uint64_t* words, const size_t count, const uint64_t hash)
+{
+	// FNV-1a over whole words, any single changed word changes the result
+	constexpr uint64_t kPrime = 0x100000001b3ULL;
+	uint64_t value = hash;
+	for (size_t i = 0; i < count; ++i)
+		value = (value ^ words[i]) * kPrime;
+	return value;
+}
+
+bool my_map_is_mapped_file(const std::wstring& fileName)
+{
+	std::ifstream ifs(fileName, std::ios::binary);
+	if (!ifs.is_open())
+		return false;
+
+	char magic[sizeof(MyMapFileHeader::kMagic)] = {};
+	ifs.read(magic, sizeof(magic));
+	return ifs.good() && (0 == memcmp(magic, MyMapFileHeader::kMagic, sizeof(magic)));
+}
+
+bool my_map_save(const MyMap& map, const std::wstring& fileName)
+{
+	if (map.chunks.empty())
+		return false;
+
+	const size_t words = map.chunk_words();
+	const size_t last = map.chunks.size() - 1;
+
+	// the rows of the last chunk past the height are written as 0 whatever the chunk holds
+	std::vector<uint64_t> tail(words, 0);
+	const size_t used = static_cast<size_t>(map.height - (static_cast<int>(last) << map.chunk_shift)) * map.stride;
+	memcpy(tail.data(), map.chunks[last].get(), used * sizeof(uint64_t));
+
+	auto chunk = [&map, &tail, last](const size_t index)
+	{
+		return (index == last) ? tail.data() : map.chunks[index].get();
+	};
+
+	MyMapFileHeader header = {};
+	memcpy(header.magic, MyMapFileHeader::kMagic, sizeof(header.magic));
+	header.format = MyMapFileHeader::kFormat;
+	header.header_size = sizeof(MyMapFileHeader);
+	header.width = map.width;
+	header.height = map.height;
+	header.stride = map.stride;
+	header.chunk_shift = map.chunk_shift;
+	header.words = words * map.chunks.size();
+	header.checksum = kMapChecksumSeed;
+	for (size_t i = 0; i <= last; ++i)
+		header.checksum = my_map_checksum(chunk(i), words, header.checksum);
+
+	std::ofstream ofs(fileName, std::ios::binary);
+	if (!ofs.is_open())
+		return false;
+
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (size_t i = 0; i <= last; ++i)
+		ofs.write(reinterpret_cast<const char*>(chunk(i)), words * sizeof(uint64_t));
+	ofs.close();
+	return !ofs.fail();
+}
+
+std::shared_ptr<MyMap> my_map_load(const std::wstring& fileName, const bool verify)
+{
+	std::shared_ptr<MyMappedView> view = std::make_shared<MyMappedView>();
+	if (!view->open(fileName) || (view->size() < sizeof(MyMapFileHeader)))
+		return nullptr;
+
+	MyMapFileHeader header = {};
+	memcpy(&header, view->data(), sizeof(header));
+	if ((0 != memcmp(header.magic, MyMapFileHeader::kMagic, sizeof(header.magic)))
+		|| (header.format != MyMapFileHeader::kFormat)
+		|| (header.header_size < sizeof(MyMapFileHeader)) || ((header.header_size & 7) != 0)
+		|| (header.header_size > view->size())
+		|| (header.width <= 0) || (header.height <= 0)
+		|| (header.stride != ((header.width + 63) >> 6))
+		|| (header.chunk_shift < 0) || (header.chunk_shift > 30))
+		return nullptr;
+
+	// in 64 bits so a crafted header can not wrap the sizes around, size_t is 32 bits on Win32
+	const uint64_t chunk_words = static_cast<uint64_t>(header.stride) << header.chunk_shift;
+	const uint64_t count = ((static_cast<uint64_t>(header.height) - 1) >> header.chunk_shift) + 1;
+	if ((chunk_words > (UINT64_MAX / count))
+		|| (header.words != chunk_words * count)
+		|| (header.words > (view->size() - header.header_size) / sizeof(uint64_t)))
+		return nullptr;
+
+	const uint64_t* body = reinterpret_cast<const uint64_t*>(view->data() + header.header_size);
+	if (verify && (my_map_checksum(body, static_cast<size_t>(header.words)) != header.checksum))
+		return nullptr;
+
+	// the padding bits past the width must be 0 like in any map built in memory, the word scans rely on it
+	// (one word per row, a corrupt cell elsewhere only reads as the wrong type)
+	if ((header.width & 63) != 0)
+	{
+		const uint64_t padding = ~((1ULL << (header.width & 63)) - 1ULL);
+		for (int y = 0; y < header.height; ++y)
+		{
+			if ((body[static_cast<size_t>(y) * header.stride + header.stride - 1] & padding) != 0)
+				return nullptr;
+		}
+	}
+
+	std::shared_ptr<MyMap> map = std::make_shared<MyMap>();
+	map->width = header.width;
+	map->height = header.height;
+	map->stride = header.stride;
+	map->chunk_shift = header.chunk_shift;
+
+	// every chunk shares the ownership of the view
+	map->chunks.reserve(static_cast<size_t>(count));
+	for (size_t i = 0; i < count; ++i)
+		map->chunks.emplace_back(view, body + i * chunk_words);
+	return map;
+}
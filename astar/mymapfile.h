@@ -0,0 +1,66 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYMAPFILE_H
+#define MYMAPFILE_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+
+// header of the mapped map file
+// the body that follows is the bit grid exactly as MyMap keeps it in memory: row-major 64-bit words,
+// 1 = road, rows padded to whole words with 0 and the last chunk padded with empty rows,
+// so a loaded map uses the mapped file itself as its chunks
+struct MyMapFileHeader
+{
+	static constexpr char kMagic[8] = { 'A', 'S', 'T', 'A', 'R', 'M', 'A', 'P' };
+	static constexpr uint32_t kFormat = 1;
+
+	char magic[8];                          // kMagic
+	uint32_t format;                        // kFormat, bumped by any layout change
+	uint32_t header_size;                   // bytes before the body, a multiple of 8
+	int32_t width;
+	int32_t height;
+	int32_t stride;                         // 64-bit words per row
+	int32_t chunk_shift;                    // log2 of rows per chunk
+	uint32_t reserved0;                     // 0, the corner setting is not part of the map
+	uint32_t reserved;
+	uint64_t words;                         // 64-bit words of the body
+	uint64_t checksum;                      // my_map_checksum of the body
+	uint64_t reserved2;
+};
+
+static_assert(sizeof(MyMapFileHeader) == 64, "the header layout is part of the file format");
+
+constexpr uint64_t kMapChecksumSeed = 0xcbf29ce484222325ULL;
+
+// checksum of the body words, pass the result of the previous part as hash to continue over several parts
+MY_REQUIRED_RESULT uint64_t __vectorcall my_map_checksum(const uint64_t* words, const size_t count, const uint64_t hash = kMapChecksumSeed);
+
+// check the file starts with the header of the mapped format
+MY_REQUIRED_RESULT bool __vectorcall my_map_is_mapped_file(const std::wstring& fileName);
+
+// write the map in the mapped format, return false if the file can not be written
+MY_REQUIRED_RESULT bool __vectorcall my_map_save(const MyMap& map, const std::wstring& fileName);
+
+// map the file read-only and return a map whose chunks point into the view, nothing is copied
+// the file stays open until no version of the map uses an unedited chunk of it
+// the body is only read where the map is used unless verify runs the checksum over all of it first
+// nullptr if the file is missing, truncated, of another format or fails the checksum
+MY_REQUIRED_RESULT std::shared_ptr<MyMap> __vectorcall my_map_load(const std::wstring& fileName, const bool verify);
+
+#endif
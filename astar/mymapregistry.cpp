@@ -0,0 +1,99 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mymapregistry.h"
+
+MyMapPtr MyMapRegistry::Writer::current() const
+{
+	return (nullptr != slot_) ? slot_->current.load(std::memory_order_acquire) : nullptr;
+}
+
+void MyMapRegistry::Writer::publish(MyMapPtr map)
+{
+	if (nullptr == slot_)
+		return;
+
+	if (nullptr == map)
+	{
+		slot_->removed = true;
+		slot_->current.store(nullptr, std::memory_order_release);
+		registry_->remove(mapid_, slot_);
+		return;
+	}
+
+	slot_->current.store(std::move(map), std::memory_order_release);
+}
+
+MyMapPtr MyMapRegistry::snapshot(const std::wstring& mapid) const
+{
+	const Shard& shard = shard_of(mapid);
+	std::shared_lock<std::shared_mutex> lck(shard.mutex);
+	auto it = shard.slots.find(mapid);
+	return (it != shard.slots.end()) ? it->second->current.load(std::memory_order_acquire) : nullptr;
+}
+
+MyMapRegistry::Writer MyMapRegistry::write(const std::wstring& mapid, const bool create)
+{
+	Shard& shard = shard_of(mapid);
+	for (;;)
+	{
+		std::shared_ptr<Slot> slot = nullptr;
+		{
+			std::shared_lock<std::shared_mutex> lck(shard.mutex);
+			auto it = shard.slots.find(mapid);
+			if (it != shard.slots.end())
+				slot = it->second;
+		}
+
+		if ((nullptr == slot) && create)
+		{
+			std::unique_lock<std::shared_mutex> lck(shard.mutex);
+			std::shared_ptr<Slot>& registered = shard.slots[mapid];
+			if (nullptr == registered)
+				registered = std::make_shared<Slot>();
+			slot = registered;
+		}
+
+		if (nullptr == slot)
+			return Writer{};
+
+		Writer writer;
+		writer.lock_ = std::unique_lock<std::mutex>(slot->write);
+
+		// the map was freed while waiting for the lock, a new slot may have been added since
+		if (slot->removed)
+		{
+			if (!create)
+				return Writer{};
+			continue;
+		}
+
+		writer.registry_ = this;
+		writer.mapid_ = mapid;
+		writer.slot_ = std::move(slot);
+		return writer;
+	}
+}
+
+void MyMapRegistry::remove(const std::wstring& mapid, const std::shared_ptr<Slot>& slot)
+{
+	Shard& shard = shard_of(mapid);
+	std::unique_lock<std::shared_mutex> lck(shard.mutex);
+	auto it = shard.slots.find(mapid);
+	if ((it != shard.slots.end()) && (it->second == slot))
+		shard.slots.erase(it);
+}
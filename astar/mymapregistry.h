@@ -0,0 +1,99 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYMAPREGISTRY_H
+#define MYMAPREGISTRY_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+
+// the published maps by id
+// ids are spread over shards with their own lock, a shard lock is only held to find a slot
+// every map has its own slot: the latest version behind an atomic pointer that readers load
+// without blocking, and a write lock that serializes the writers of that map only
+class MyMapRegistry
+{
+	MY_DISABLE_COPY_MOVE(MyMapRegistry)
+private:
+	struct Slot
+	{
+		std::mutex write;                   // held by the writer of this map
+		std::atomic<MyMapPtr> current;      // latest published version
+		bool removed = false;               // the map was freed, guarded by write
+	};
+
+public:
+	// exclusive write access to one map, released when destroyed
+	class Writer
+	{
+	public:
+		explicit Writer() = default;
+
+		MY_REQUIRED_RESULT explicit operator bool() const { return nullptr != slot_; }
+
+		// latest published version, nullptr for a new map or an empty writer
+		MY_REQUIRED_RESULT MyMapPtr current() const;
+
+		// swap in a new version, nullptr removes the map from the registry
+		void __vectorcall publish(MyMapPtr map);
+
+	private:
+		friend class MyMapRegistry;
+
+		MyMapRegistry* registry_ = nullptr;
+		std::wstring mapid_;
+		std::shared_ptr<Slot> slot_ = nullptr;
+		std::unique_lock<std::mutex> lock_;
+	};
+
+	static constexpr size_t kShardCount = 16;
+
+	explicit MyMapRegistry() = default;
+
+	virtual ~MyMapRegistry() = default;
+
+	// pin the latest version of the map, nullptr if the map does not exist
+	MY_REQUIRED_RESULT MyMapPtr __vectorcall snapshot(const std::wstring& mapid) const;
+
+	// lock the map for writing, waits only for the other writers of the same map
+	// with create a slot is added for a new map, otherwise the writer is empty if the map does not exist
+	MY_REQUIRED_RESULT Writer __vectorcall write(const std::wstring& mapid, const bool create);
+
+private:
+	struct alignas(64) Shard
+	{
+		mutable std::shared_mutex mutex;
+		std::unordered_map<std::wstring, std::shared_ptr<Slot>> slots;
+	};
+
+	Shard shards_[kShardCount];
+
+	MY_REQUIRED_RESULT __forceinline Shard& shard_of(const std::wstring& mapid)
+	{
+		return shards_[std::hash<std::wstring>()(mapid) % kShardCount];
+	}
+
+	MY_REQUIRED_RESULT __forceinline const Shard& shard_of(const std::wstring& mapid) const
+	{
+		return shards_[std::hash<std::wstring>()(mapid) % kShardCount];
+	}
+
+	// drop the slot of the map if it is still the registered one
+	void __vectorcall remove(const std::wstring& mapid, const std::shared_ptr<Slot>& slot);
+};
+
+#endif
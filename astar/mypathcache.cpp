@@ -0,0 +1,195 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mypathcache.h"
+
+size_t MyPathCache::KeyHash::operator()(const Key& key) const
+{
+	size_t h = std::hash<std::wstring>()(key.mapid);
+	auto mix = [&h](const size_t v)
+	{
+		h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	};
+	mix(static_cast<uint32_t>(key.start.x()) | (static_cast<size_t>(static_cast<uint32_t>(key.start.y())) << 32));
+	mix(static_cast<uint32_t>(key.end.x()) | (static_cast<size_t>(static_cast<uint32_t>(key.end.y())) << 32));
+	mix((static_cast<size_t>(key.engine) << 1) | (key.corner ? 1 : 0));
+	return h;
+}
+
+void MyPathCache::set_budget(const size_t bytes)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	budget_ = bytes;
+	shrink();
+}
+
+bool MyPathCache::get(const Key& key, const uint64_t version, std::vector<MyPoint>* path)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	auto it = index_.find(key);
+	if (it == index_.end())
+	{
+		++stats_.misses;
+		return false;
+	}
+
+	if (it->second->version != version)
+	{
+		// the map changed in a way the edit hooks did not follow
+		remove(it->second);
+		++stats_.invalidations;
+		++stats_.misses;
+		return false;
+	}
+
+	entries_.splice(entries_.begin(), entries_, it->second);
+	*path = it->second->path;
+	++stats_.hits;
+	return true;
+}
+
+void MyPathCache::put(const Key& key, const uint64_t version, const std::vector<MyPoint>& path)
+{
+	Entry entry{ key, version, path };
+	entry.bytes = sizeof(Entry) + (key.mapid.size() * sizeof(wchar_t)) + (path.size() * sizeof(MyPoint));
+
+	int left = key.start.x();
+	int top = key.start.y();
+	int right = left;
+	int bottom = top;
+	for (const MyPoint& pos : path)
+	{
+		left = (std::min)(left, pos.x());
+		top = (std::min)(top, pos.y());
+		right = (std::max)(right, pos.x());
+		bottom = (std::max)(bottom, pos.y());
+	}
+	entry.box = MyRect{ left, top, right - left + 1, bottom - top + 1 };
+
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (entry.bytes > budget_)
+		return;
+
+	auto it = index_.find(key);
+	if (it != index_.end())
+		remove(it->second);
+
+	entries_.push_front(std::move(entry));
+	index_.emplace(key, entries_.begin());
+	stats_.bytes += entries_.front().bytes;
+	++stats_.entries;
+	shrink();
+}
+
+void MyPathCache::add_collision(const std::wstring& mapid, const MyMap& map, const std::vector<MyRect>& rects, const uint64_t from, const uint64_t to)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	auto it = entries_.begin();
+	while (it != entries_.end())
+	{
+		if (it->key.mapid != mapid)
+		{
+			++it;
+			continue;
+		}
+
+		// a new wall that is neither on the path nor beside one of its diagonal steps leaves it passable
+		// and can not make any other path shorter, the corner cells of a step lie inside the box as well
+		const MyRect& box = it->box;
+		bool touched = (it->version != from);
+		for (const MyRect& rect : rects)
+		{
+			if (touched)
+				break;
+
+			if ((rect.x >= box.x + box.w) || (box.x >= rect.x + rect.w) || (rect.y >= box.y + box.h) || (box.y >= rect.y + rect.h))
+				continue;
+
+			auto blocked = [&map, &rect](const int x, const int y)
+			{
+				return (x >= rect.x) && (x < rect.x + rect.w) && (y >= rect.y) && (y < rect.y + rect.h)
+					&& !map.is_road(x, y);
+			};
+
+			// a diagonal step of an 8-dir path needs both straight neighbours, like MyAStar::find_can_pass_nodes
+			MyPoint prev = it->key.start;
+			touched = blocked(prev.x(), prev.y());
+			for (const MyPoint& pos : it->path)
+			{
+				if (touched)
+					break;
+
+				touched = blocked(pos.x(), pos.y())
+					|| (it->key.corner && (prev.x() != pos.x()) && (prev.y() != pos.y())
+						&& (blocked(prev.x(), pos.y()) || blocked(pos.x(), prev.y())));
+				prev = pos;
+			}
+		}
+
+		if (touched)
+		{
+			it = remove(it);
+			++stats_.invalidations;
+		}
+		else
+		{
+			it->version = to;
+			++it;
+		}
+	}
+}
+
+void MyPathCache::erase(const std::wstring& mapid)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	auto it = entries_.begin();
+	while (it != entries_.end())
+	{
+		if (it->key.mapid == mapid)
+		{
+			it = remove(it);
+			++stats_.invalidations;
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+MyPathCache::Stats MyPathCache::stats() const
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	return stats_;
+}
+
+MyPathCache::List::iterator MyPathCache::remove(List::iterator it)
+{
+	stats_.bytes -= it->bytes;
+	--stats_.entries;
+	index_.erase(it->key);
+	return entries_.erase(it);
+}
+
+void MyPathCache::shrink()
+{
+	while (!entries_.empty() && (stats_.bytes > budget_))
+	{
+		remove(std::prev(entries_.end()));
+		++stats_.evictions;
+	}
+}
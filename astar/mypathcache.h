@@ -0,0 +1,111 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYPATHCACHE_H
+#define MYPATHCACHE_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+
+// LRU cache of found paths bounded by a byte budget, disabled while the budget is 0
+// an entry is only handed out for the map version it was found on, a new collision moves the
+// entries whose path it does not touch to the next version, anything else drops them
+class MyPathCache
+{
+	MY_DISABLE_COPY_MOVE(MyPathCache)
+public:
+	struct Key
+	{
+		std::wstring mapid;
+		MyPoint start;
+		MyPoint end;
+		bool corner = true;
+		int engine = 0;
+
+		bool operator== (const Key& other) const
+		{
+			return (start == other.start) && (end == other.end) && (corner == other.corner)
+				&& (engine == other.engine) && (mapid == other.mapid);
+		}
+	};
+
+	struct Stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;             // dropped to stay inside the budget
+		uint64_t invalidations = 0;         // dropped by edits or version changes
+		size_t bytes = 0;
+		size_t entries = 0;
+	};
+
+	explicit MyPathCache() = default;
+
+	virtual ~MyPathCache() = default;
+
+	// set the byte budget, entries are evicted until they fit, 0 disables the cache and clears it
+	void __vectorcall set_budget(const size_t bytes);
+
+	MY_REQUIRED_RESULT __forceinline bool enabled() const { return budget_ > 0; }
+
+	// get the cached path of the version, counted as a hit or a miss
+	MY_REQUIRED_RESULT bool __vectorcall get(const Key& key, const uint64_t version, std::vector<MyPoint>* path);
+
+	// remember the path found on the version
+	void __vectorcall put(const Key& key, const uint64_t version, const std::vector<MyPoint>& path);
+
+	// collisions were added inside the rectangles, and nothing else changed, while the map went
+	// from version from to the version to, map is the new version
+	// entries whose path crosses a new wall, or cuts a corner a new wall now blocks, are dropped
+	void __vectorcall add_collision(const std::wstring& mapid, const MyMap& map, const std::vector<MyRect>& rects, const uint64_t from, const uint64_t to);
+
+	// drop every entry of the map
+	void __vectorcall erase(const std::wstring& mapid);
+
+	MY_REQUIRED_RESULT Stats stats() const;
+
+private:
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	struct Entry
+	{
+		Key key;
+		uint64_t version = 0;
+		std::vector<MyPoint> path;
+		MyRect box;                         // bounding box of start and the path, a cheap test before the scan
+		size_t bytes = 0;
+	};
+
+	using List = std::list<Entry>;
+
+	mutable std::mutex mutex_;
+	std::atomic<size_t> budget_ = 0;
+	List entries_;                          // most recently used first
+	std::unordered_map<Key, List::iterator, KeyHash> index_;
+	Stats stats_;
+
+	// drop the entry, the lock must be held
+	List::iterator __vectorcall remove(List::iterator it);
+
+	// evict the least recently used entries until the budget is kept, the lock must be held
+	void __vectorcall shrink();
+};
+
+#endif
@@ -1,58 +1,162 @@
-﻿/*
-* Copyright (c) 2019-2022 bestkakkoii llc.
-*
-* This software is provided 'as-is', without any express or implied
-* warranty.  In no event will the authors be held liable for any damages
-* arising from the use of this software.
-* Permission is granted to anyone to use this software for any purpose,
-* including commercial applications, and to alter it and redistribute it
-* freely, subject to the following restrictions:
-* 1. The origin of this software must not be misrepresented; you must not
-* claim that you wrote the original software. If you use this software
-* in a product, an acknowledgment in the product documentation would be
-* appreciated but is not required.
-* 2. Altered source versions must be plainly marked as such, and must not be
-* misrepresented as being the original software.
-* 3. This notice may not be removed or altered from any source distribution.
-*/
-#include "mypoint.h"
-
-MyPoint::MyPoint(int xpos, int ypos)
-	: xp(xpos)
-	, yp(ypos)
-{
-}
-
-int MyPoint::x() const
-{
-	return xp;
-}
-
-int MyPoint::y() const
-{
-	return yp;
-}
-
-void MyPoint::reset(int x1, int y1)
-{
-	xp = x1;
-	yp = y1;
-}
-
-bool MyPoint::isNull() const
-{
-	return (xp == 0 && yp == 0);
-}
-
-int MyPoint::manhattanLength() const
-{
-	return static_cast<int>(abs(x()) + abs(y()));
-}
-
-POINT MyPoint::toPoint() const
-{
-	POINT p;
-	p.x = xp;
-	p.y = yp;
-	return p;
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mypoint.h"
+
+MyPoint::MyPoint(int xpos, int ypos)
+	: xp(xpos)
+	, yp(ypos)
+{
+}
+
+int MyPoint::x() const
+{
+	return xp;
+}
+
+int MyPoint::y() const
+{
+	return yp;
+}
+
+void MyPoint::reset(int x1, int y1)
+{
+	xp = x1;
+	yp = y1;
+}
+
+bool MyPoint::isNull() const
+{
+	return (xp == 0 && yp == 0);
+}
+
+int MyPoint::manhattanLength() const
+{
+	return static_cast<int>(abs(x()) + abs(y()));
+}
+
+POINT MyPoint::toPoint() const
+{
+	POINT p;
+	p.x = xp;
+	p.y = yp;
+	return p;
+}
+
+void my_turning_points(const MyPoint& start, const std::vector<MyPoint>& path, std::vector<MyPoint>* out)
+{
+	const size_t size = path.size();
+	MyPoint previous = start;
+	for (size_t i = 0; i < size; ++i)
+	{
+		// the last point always stays, any other one only if the next step leaves the current line
+		if (i + 1 == size)
+		{
+			out->push_back(path[i]);
+			break;
+		}
+
+		const MyPoint in = path[i] - previous;
+		const MyPoint next = path[i + 1] - path[i];
+		if ((in.x() * next.y() != in.y() * next.x()) || (in.x() * next.x() + in.y() * next.y() <= 0))
+			out->push_back(path[i]);
+		previous = path[i];
+	}
+}
+
+static __forceinline void put_int32(const int value, std::vector<uint8_t>* out)
+{
+	uint8_t bytes[4] = {};
+	memcpy(bytes, &value, sizeof(bytes));
+	out->insert(out->end(), bytes, bytes + sizeof(bytes));
+}
+
+static __forceinline void put_varint(const int value, std::vector<uint8_t>* out)
+{
+	// zigzag keeps small negative numbers small
+	uint32_t bits = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+	while (bits >= 0x80)
+	{
+		out->push_back(static_cast<uint8_t>(bits | 0x80));
+		bits >>= 7;
+	}
+	out->push_back(static_cast<uint8_t>(bits));
+}
+
+bool my_encode_path(const std::vector<MyPoint>& points, const int encoding, std::vector<uint8_t>* out)
+{
+	if (points.empty())
+		return (PATH_POINTS == encoding) || (PATH_DELTA == encoding) || (PATH_VARINT == encoding);
+
+	switch (encoding)
+	{
+	case PATH_POINTS:
+	{
+		out->reserve(out->size() + points.size() * 8);
+		for (const MyPoint& pos : points)
+		{
+			put_int32(pos.x(), out);
+			put_int32(pos.y(), out);
+		}
+		return true;
+	}
+	case PATH_DELTA:
+	{
+		out->reserve(out->size() + 8 + points.size() * 2);
+		put_int32(points.front().x(), out);
+		put_int32(points.front().y(), out);
+
+		const size_t size = points.size();
+		for (size_t i = 1; i < size; ++i)
+		{
+			int dx = points[i].x() - points[i - 1].x();
+			int dy = points[i].y() - points[i - 1].y();
+
+			// the deltas of a turning point path are straight or diagonal, so equal parts stay on the line
+			const int parts = ((std::max)(std::abs(dx), std::abs(dy)) + 126) / 127;
+			for (int part = parts; part > 1; --part)
+			{
+				const int sx = dx / part;
+				const int sy = dy / part;
+				out->push_back(static_cast<uint8_t>(static_cast<int8_t>(sx)));
+				out->push_back(static_cast<uint8_t>(static_cast<int8_t>(sy)));
+				dx -= sx;
+				dy -= sy;
+			}
+			out->push_back(static_cast<uint8_t>(static_cast<int8_t>(dx)));
+			out->push_back(static_cast<uint8_t>(static_cast<int8_t>(dy)));
+		}
+		return true;
+	}
+	case PATH_VARINT:
+	{
+		out->reserve(out->size() + points.size() * 2 + 8);
+		put_varint(points.front().x(), out);
+		put_varint(points.front().y(), out);
+
+		const size_t size = points.size();
+		for (size_t i = 1; i < size; ++i)
+		{
+			put_varint(points[i].x() - points[i - 1].x(), out);
+			put_varint(points[i].y() - points[i - 1].y(), out);
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
 }
\ No newline at end of file
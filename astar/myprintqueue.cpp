@@ -0,0 +1,168 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "myprintqueue.h"
+
+std::shared_ptr<const qimage> my_render_map(const MyMap& map, const MyRGB& road, const MyRGB& wall)
+{
+	std::shared_ptr<qimage> img = std::make_shared<qimage>(map.width, map.height);
+	int x = 0;
+	for (int y = 0; y < map.height; ++y)
+	{
+		const uint64_t* words = map.row(y);
+		for (x = 0; x < map.width; ++x)
+			img->setPixel(MyPoint{ x, y }, ((words[x >> 6] >> (x & 63)) & 1ULL) ? road : wall);
+	}
+	return img;
+}
+
+bool my_write_image(const qimage& img, const std::wstring& fileName)
+{
+	// binary, a text stream would turn every 0x0a byte of the pixels into two bytes
+	std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	file << img;
+	return file.good();
+}
+
+MyPrintQueue& MyPrintQueue::instance()
+{
+	static MyPrintQueue* queue = new MyPrintQueue();
+	return *queue;
+}
+
+MyPrintQueue::MyPrintQueue(const size_t depth)
+	: depth_((std::max)(depth, static_cast<size_t>(1)))
+{
+}
+
+MyPrintQueue::~MyPrintQueue()
+{
+	stop();
+}
+
+void MyPrintQueue::stop()
+{
+	// the writer is taken out under the lock, so a push can neither see nor replace it while it is joined
+	std::thread writer;
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		stop_ = true;
+		writer = std::move(writer_);
+	}
+	wakeup_.notify_all();
+
+	if (writer.joinable())
+		writer.join();
+}
+
+bool MyPrintQueue::push(Job job)
+{
+	bool kept = true;
+	{
+		std::unique_lock<std::mutex> lck(mutex_);
+		if (stop_)
+		{
+			// no thread is started again, the image is written on the calling thread
+			lck.unlock();
+			write(job);
+			return true;
+		}
+
+		if (jobs_.size() >= depth_)
+		{
+			jobs_.pop_front();
+			kept = false;
+		}
+		jobs_.push_back(std::move(job));
+
+		if (!writer_.joinable())
+			writer_ = std::thread(&MyPrintQueue::run, this);
+	}
+	wakeup_.notify_one();
+	return kept;
+}
+
+void MyPrintQueue::forget(const std::wstring& mapid)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	bases_.erase(mapid);
+}
+
+std::shared_ptr<const qimage> MyPrintQueue::base_of(const Job& job)
+{
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		auto it = bases_.find(job.mapid);
+		if ((it != bases_.end()) && (it->second.version == job.map->version)
+			&& (it->second.road == job.road) && (it->second.wall == job.wall))
+		{
+			it->second.used = ++tick_;
+			return it->second.image;
+		}
+	}
+
+	// drawn without the lock, queries keep queueing meanwhile
+	std::shared_ptr<const qimage> image = my_render_map(*job.map, job.road, job.wall);
+
+	std::lock_guard<std::mutex> lck(mutex_);
+	bases_[job.mapid] = Base{ job.map->version, job.road, job.wall, image, ++tick_ };
+
+	// evict the least recently used bases beyond the budget, the one just drawn stays
+	size_t bytes = 0;
+	for (const auto& it : bases_)
+		bytes += it.second.image->size();
+
+	while ((bases_.size() > 1) && (bytes > kMaxBaseBytes))
+	{
+		auto oldest = std::ranges::min_element(bases_, {}, [](const auto& it) { return it.second.used; });
+		bytes -= oldest->second.image->size();
+		bases_.erase(oldest);
+	}
+	return image;
+}
+
+void MyPrintQueue::write(const Job& job)
+{
+	// copy the base and walk the path once
+	qimage img = *base_of(job);
+	for (const MyPoint& pos : job.path)
+		img.setPixel(pos, job.colour);
+
+	(void)my_write_image(img, job.fileName);
+}
+
+void MyPrintQueue::run()
+{
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lck(mutex_);
+			wakeup_.wait(lck, [this]() { return stop_ || !jobs_.empty(); });
+			if (jobs_.empty())
+				break;
+
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+
+		write(job);
+	}
+}
@@ -0,0 +1,101 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYPRINTQUEUE_H
+#define MYPRINTQUEUE_H
+#pragma execution_character_set("utf-8")
+#include "mydraw.hpp"
+#include "mymap.h"
+
+// draw the map in the road and wall colours, the base every printed path is painted on
+MY_REQUIRED_RESULT std::shared_ptr<const qimage> __vectorcall my_render_map(const MyMap& map, const MyRGB& road, const MyRGB& wall);
+
+// write the image as a 24-bit bitmap file, return false if the file can not be written
+MY_REQUIRED_RESULT bool __vectorcall my_write_image(const qimage& img, const std::wstring& fileName);
+
+// background writer of the images printed after a path is found
+// queries only queue a job, one thread paints the path on a cached base image of the map version and writes the file
+// the queue is bounded, a full queue drops its oldest job so a slow disk can not hold up the queries or the memory
+class MyPrintQueue
+{
+	MY_DISABLE_COPY_MOVE(MyPrintQueue)
+
+	// bytes of the cached base images, the least recently used maps are drawn again beyond it
+	static constexpr size_t kMaxBaseBytes = 64ull * 1024 * 1024;
+
+public:
+	struct Job
+	{
+		std::wstring mapid;
+		MyMapPtr map;                       // the version the path was found on
+		std::vector<MyPoint> path;
+		MyRGB road;
+		MyRGB wall;
+		MyRGB colour;                       // colour of the path
+		std::wstring fileName;
+	};
+
+	// the queue of the library, never destroyed, a static destructor would join the writer
+	// under the loader lock of DLL_PROCESS_DETACH
+	static MyPrintQueue& instance();
+
+	explicit MyPrintQueue(const size_t depth = 8);
+
+	// write the jobs still queued and stop the writer
+	virtual ~MyPrintQueue();
+
+	// write the jobs still queued and join the writer, later jobs are written by push on the calling thread
+	void stop();
+
+	// queue the job and start the writer on first use, after stop the image is written at once instead
+	// return false if the oldest queued job was dropped to make room
+	bool __vectorcall push(Job job);
+
+	// drop the cached base image of the map
+	void __vectorcall forget(const std::wstring& mapid);
+
+private:
+	struct Base
+	{
+		uint64_t version = 0;
+		MyRGB road = {};
+		MyRGB wall = {};
+		std::shared_ptr<const qimage> image = nullptr;
+		uint64_t used = 0;                  // tick_ of the last job drawn on it
+	};
+
+	const size_t depth_;
+	std::mutex mutex_;                      // guards jobs_, bases_, tick_, writer_ and stop_
+	std::condition_variable wakeup_;
+	std::deque<Job> jobs_;
+	std::unordered_map<std::wstring, Base> bases_;  // last base image drawn per map, at most kMaxBaseBytes
+	uint64_t tick_ = 0;
+	std::thread writer_;
+	bool stop_ = false;                     // set for good by stop, no writer is started afterwards
+
+	// base image of the job's map version in its colours, drawn again only when either changed
+	MY_REQUIRED_RESULT std::shared_ptr<const qimage> __vectorcall base_of(const Job& job);
+
+	// paint the path of the job on its base and write the file
+	void __vectorcall write(const Job& job);
+
+	// writer loop
+	void __vectorcall run();
+};
+
+#endif
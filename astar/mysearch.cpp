@@ -0,0 +1,96 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mysearch.h"
+
+MySearch::MySearch(const MyMapPtr& map, const MyParams& param)
+	: map_(map)
+{
+	// points in different components never meet, the search is over before it starts
+	const MyMap& grid = *map_;
+	if ((nullptr != grid.components) && grid.contains(param.start.x(), param.start.y())
+		&& grid.contains(param.end.x(), param.end.y()) && grid.components->separated(param.start, param.end))
+	{
+		return;
+	}
+
+	context_.emplace(MyContextPool::local().acquire(param.width, param.height));
+
+	const MyGridPass can_pass{ &grid };
+	const bool ready = param.corner
+		? astar_.emplace<Search8>(context_->get(), can_pass).begin(param)
+		: astar_.emplace<Search4>(context_->get(), can_pass).begin(param);
+
+	if (ready)
+	{
+		status_ = SEARCH_EXPANSIONS;
+	}
+	else
+	{
+		finish();
+	}
+}
+
+SEARCHSTATUS MySearch::step(const MyBudget& budget)
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	if (Search8* astar = std::get_if<Search8>(&astar_))
+	{
+		status_ = astar->resume(budget, &path_);
+	}
+	else if (Search4* astar = std::get_if<Search4>(&astar_))
+	{
+		status_ = astar->resume(budget, &path_);
+	}
+
+	if ((SEARCH_FOUND == status_) || (SEARCH_NOPATH == status_))
+	{
+		finish();
+	}
+	return status_;
+}
+
+SEARCHSTATUS MySearch::status() const
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	return status_;
+}
+
+void MySearch::path(std::vector<MyPoint>* out) const
+{
+	std::lock_guard<std::mutex> lck(mutex_);
+	out->clear();
+	if (const Search8* astar = std::get_if<Search8>(&astar_))
+	{
+		astar->partial_path(out);
+	}
+	else if (const Search4* astar = std::get_if<Search4>(&astar_))
+	{
+		astar->partial_path(out);
+	}
+	else
+	{
+		*out = path_;
+	}
+}
+
+void MySearch::finish()
+{
+	// the search refers to the context, it goes first
+	astar_.emplace<std::monostate>();
+	context_.reset();
+}
@@ -0,0 +1,60 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYSEARCH_H
+#define MYSEARCH_H
+#pragma execution_character_set("utf-8")
+#include "myastar.h"
+#include "mycomponents.h"
+
+// an A* query on a pinned version of a map that runs a slice at a time, so many queries can take turns on one thread
+// the node table and the open list are a context leased from the pool of the thread,
+// it goes back to the pool as soon as the search is over
+class MySearch
+{
+	MY_DISABLE_COPY_MOVE(MySearch)
+public:
+	explicit MySearch(const MyMapPtr& map, const MyParams& param);
+
+	virtual ~MySearch() = default;
+
+	// run the search for one slice of at most budget.expansions expansions and budget.micros microseconds
+	// return SEARCH_EXPANSIONS or SEARCH_TIMEOUT while in progress, SEARCH_FOUND or SEARCH_NOPATH once it is over
+	MY_REQUIRED_RESULT SEARCHSTATUS __vectorcall step(const MyBudget& budget);
+
+	MY_REQUIRED_RESULT SEARCHSTATUS status() const;
+
+	// get the path once found, while in progress the path to the expanded node closest to the end
+	void __vectorcall path(std::vector<MyPoint>* out) const;
+
+private:
+	using Search8 = MyAStar<MyGridPass, true>;
+	using Search4 = MyAStar<MyGridPass, false>;
+
+	mutable std::mutex mutex_;              // one step at a time
+	MyMapPtr map_;
+	std::optional<MyContextLease> context_;
+	std::variant<std::monostate, Search8, Search4> astar_;
+	SEARCHSTATUS status_ = SEARCH_NOPATH;   // in progress while it is a limit
+	std::vector<MyPoint> path_;
+
+	// drop the search state and hand the context back
+	void finish();
+};
+
+#endif
@@ -0,0 +1,204 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "mythreadpool.h"
+
+// index of the worker running on this thread, -1 for any other thread
+static thread_local int t_worker = -1;
+
+MyThreadPool& MyThreadPool::instance()
+{
+	static MyThreadPool* pool = new MyThreadPool((std::max)(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0));
+	return *pool;
+}
+
+MyThreadPool::MyThreadPool(const int workers)
+{
+	queues_.reserve(workers);
+	for (int i = 0; i < workers; ++i)
+		queues_.push_back(std::make_unique<Queue>());
+
+	workers_.reserve(workers);
+	for (int i = 0; i < workers; ++i)
+		workers_.emplace_back(&MyThreadPool::run, this, i);
+}
+
+MyThreadPool::~MyThreadPool()
+{
+	stop();
+}
+
+void MyThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		stop_ = true;
+	}
+	wakeup_.notify_all();
+
+	// a worker only leaves its loop once every queue is empty
+	for (std::thread& t : workers_)
+	{
+		if (t.joinable())
+			t.join();
+	}
+	workers_.clear();
+}
+
+void MyThreadPool::push(std::function<void()> task)
+{
+	const size_t index = (t_worker >= 0) ? static_cast<size_t>(t_worker) : (next_++ % queues_.size());
+
+	// counted before it is queued, a worker popping it at once must not take pending_ below 0
+	{
+		std::lock_guard<std::mutex> lck(mutex_);
+		++pending_;
+	}
+	{
+		std::lock_guard<std::mutex> lck(queues_[index]->mutex);
+		queues_[index]->tasks.push_back(std::move(task));
+	}
+	wakeup_.notify_one();
+}
+
+bool MyThreadPool::pop(std::function<void()>* task)
+{
+	const size_t count = queues_.size();
+	if (t_worker >= 0)
+	{
+		Queue& own = *queues_[t_worker];
+		std::lock_guard<std::mutex> lck(own.mutex);
+		if (!own.tasks.empty())
+		{
+			*task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			--pending_;
+			return true;
+		}
+	}
+
+	const size_t first = (t_worker >= 0) ? static_cast<size_t>(t_worker) + 1 : 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		Queue& other = *queues_[(first + i) % count];
+		std::lock_guard<std::mutex> lck(other.mutex);
+		if (!other.tasks.empty())
+		{
+			*task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			--pending_;
+			return true;
+		}
+	}
+	return false;
+}
+
+void MyThreadPool::run(const int index)
+{
+	t_worker = index;
+
+	std::function<void()> task;
+	for (;;)
+	{
+		if (pop(&task))
+		{
+			task();
+			task = nullptr;
+			continue;
+		}
+
+		// a stopping pool still drains the tasks queued before stop
+		std::unique_lock<std::mutex> lck(mutex_);
+		wakeup_.wait(lck, [this]() { return stop_ || (pending_ > 0); });
+		if (stop_ && (pending_ == 0))
+			break;
+	}
+}
+
+void MyThreadPool::submit(std::function<void()> task)
+{
+	if (workers_.empty())
+	{
+		task();
+		return;
+	}
+
+	push(std::move(task));
+}
+
+void MyThreadPool::parallel_for(const int count, const int grain, const std::function<void(int, int)>& fn)
+{
+	if (count <= 0)
+		return;
+
+	const int step = (std::max)(grain, 1);
+	const int tasks = (count + step - 1) / step;
+	if (workers_.empty() || (tasks == 1))
+	{
+		fn(0, count);
+		return;
+	}
+
+	// the ranges are claimed from the batch, so the calling thread only ever runs ranges of its own call
+	// and never an unrelated task that might wait on a lock the caller holds
+	struct Batch
+	{
+		const std::function<void(int, int)>* fn = nullptr;
+		int count = 0;
+		int step = 0;
+		int tasks = 0;
+		std::atomic<int> next = 0;
+		std::atomic<int> remaining = 0;
+		std::mutex mutex;
+		std::condition_variable done;
+
+		// run unclaimed ranges until there are none left
+		void drain()
+		{
+			for (int i = next++; i < tasks; i = next++)
+			{
+				const int begin = i * step;
+				(*fn)(begin, (std::min)(begin + step, count));
+				if (--remaining == 0)
+				{
+					std::lock_guard<std::mutex> lck(mutex);
+					done.notify_all();
+				}
+			}
+		}
+	};
+
+	std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+	batch->fn = &fn;
+	batch->count = count;
+	batch->step = step;
+	batch->tasks = tasks;
+	batch->remaining = tasks;
+
+	// a task that starts after the call returned finds no range left and does not touch fn
+	const int helpers = (std::min)(tasks - 1, static_cast<int>(workers_.size()));
+	for (int i = 0; i < helpers; ++i)
+	{
+		push([batch]() { batch->drain(); });
+	}
+
+	// the ranges left after this are the ones other threads are running
+	batch->drain();
+
+	std::unique_lock<std::mutex> lck(batch->mutex);
+	batch->done.wait(lck, [&batch]() { return batch->remaining == 0; });
+}
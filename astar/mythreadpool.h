@@ -0,0 +1,79 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef MYTHREADPOOL_H
+#define MYTHREADPOOL_H
+#pragma execution_character_set("utf-8")
+#include "myglobal.hpp"
+
+// work-stealing thread pool shared by batch queries and map preprocessing
+// every worker owns a deque, it takes its own tasks from the back and steals from the front of the others
+// a thread waiting in parallel_for runs the ranges of its own call that no worker took yet, so nested use
+// can not starve the pool, and it never runs an unrelated task that could need a lock the caller holds
+class MyThreadPool
+{
+	MY_DISABLE_COPY_MOVE(MyThreadPool)
+public:
+	// one worker per hardware thread apart from the calling one
+	// never destroyed, a static destructor would join the workers under the loader lock of DLL_PROCESS_DETACH
+	static MyThreadPool& instance();
+
+	explicit MyThreadPool(const int workers);
+
+	// stop and join the workers
+	virtual ~MyThreadPool();
+
+	// let the workers finish the queued tasks, then join them, later calls run every task on the calling thread
+	// no other call may run meanwhile
+	void stop();
+
+	// threads that run tasks of a parallel_for, the calling thread included
+	MY_REQUIRED_RESULT int concurrency() const { return static_cast<int>(workers_.size()) + 1; }
+
+	// run fn(begin, end) over [0, count) in ranges of at most grain items and return when all are done
+	void __vectorcall parallel_for(const int count, const int grain, const std::function<void(int, int)>& fn);
+
+	// run the task in the background, on the calling thread if the pool has no workers
+	void __vectorcall submit(std::function<void()> task);
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues_;  // one per worker
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;                      // guards the sleep of idle workers
+	std::condition_variable wakeup_;
+	std::atomic<size_t> pending_ = 0;       // tasks in all queues
+	std::atomic<size_t> next_ = 0;          // round robin queue for tasks pushed from outside
+	bool stop_ = false;
+
+	// queue a task, a worker pushes to its own queue
+	void __vectorcall push(std::function<void()> task);
+
+	// take a task from the own queue or steal one
+	MY_REQUIRED_RESULT bool __vectorcall pop(std::function<void()>* task);
+
+	// worker loop
+	void __vectorcall run(const int index);
+};
+
+#endif
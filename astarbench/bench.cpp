@@ -0,0 +1,155 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include <iostream>
+
+constexpr int kStepValue = 10;
+constexpr int kObliqueValue = 14;
+
+void my_bench_keep(const uint64_t value)
+{
+	static volatile uint64_t sink = 0;
+	sink = sink + value;
+}
+
+MyMapPtr my_bench_open_map(const int w, const int h, const double density, const unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<double> dist(0.0, 1.0);
+	MyMapEditor editor(w, h, TYPE_ROAD);
+	for (int y = 0; y < h; ++y)
+	{
+		for (int x = 0; x < w; ++x)
+		{
+			if (dist(rng) < density)
+				editor.set(x, y, TYPE_COLLISION);
+		}
+	}
+	return editor.publish(seed + 1);
+}
+
+MyMapPtr my_bench_maze_map(const int w, const int h, const unsigned seed)
+{
+	// carve a spanning tree of the odd cells with a depth-first walk
+	std::mt19937 rng(seed);
+	MyMapEditor editor(w, h, TYPE_COLLISION);
+	const int cw = (w - 1) / 2;
+	const int ch = (h - 1) / 2;
+	if ((cw <= 0) || (ch <= 0))
+		return editor.publish(seed + 1);
+
+	std::vector<uint8_t> visited(static_cast<size_t>(cw) * ch, 0);
+	std::vector<MyPoint> stack;
+	stack.emplace_back(0, 0);
+	visited[0] = 1;
+	editor.set(1, 1, TYPE_ROAD);
+
+	constexpr int dx[4] = { 1, -1, 0, 0 };
+	constexpr int dy[4] = { 0, 0, 1, -1 };
+	while (!stack.empty())
+	{
+		const MyPoint cell = stack.back();
+		int next[4] = {};
+		int count = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const int nx = cell.x() + dx[i];
+			const int ny = cell.y() + dy[i];
+			if ((nx >= 0) && (nx < cw) && (ny >= 0) && (ny < ch) && !visited[static_cast<size_t>(ny) * cw + nx])
+				next[count++] = i;
+		}
+
+		if (!count)
+		{
+			stack.pop_back();
+			continue;
+		}
+
+		const int i = next[rng() % count];
+		const int nx = cell.x() + dx[i];
+		const int ny = cell.y() + dy[i];
+		visited[static_cast<size_t>(ny) * cw + nx] = 1;
+		editor.set(cell.x() * 2 + 1 + dx[i], cell.y() * 2 + 1 + dy[i], TYPE_ROAD);
+		editor.set(nx * 2 + 1, ny * 2 + 1, TYPE_ROAD);
+		stack.emplace_back(nx, ny);
+	}
+	return editor.publish(seed + 1);
+}
+
+std::vector<std::pair<MyPoint, MyPoint>> my_bench_queries(const MyMap& map, const int count, const int min_distance, const unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> xs(0, map.width - 1);
+	std::uniform_int_distribution<int> ys(0, map.height - 1);
+	auto road = [&]()->MyPoint
+	{
+		for (;;)
+		{
+			const int x = xs(rng);
+			const int y = ys(rng);
+			if (map.is_road(x, y))
+				return MyPoint{ x, y };
+		}
+	};
+
+	std::vector<std::pair<MyPoint, MyPoint>> queries;
+	queries.reserve(count);
+	while (static_cast<int>(queries.size()) < count)
+	{
+		const MyPoint a = road();
+		const MyPoint b = road();
+		if ((std::max)(std::abs(a.x() - b.x()), std::abs(a.y() - b.y())) >= min_distance)
+			queries.emplace_back(a, b);
+	}
+	return queries;
+}
+
+size_t my_bench_expanded(const MySearchContext& context)
+{
+	size_t count = 0;
+	const int size = context.width() * context.height();
+	for (int i = 0; i < size; ++i)
+	{
+		const Node* node = context.node(i);
+		if ((nullptr != node) && (IN_CLOSEDLIST == node->state))
+			++count;
+	}
+	return count;
+}
+
+int my_bench_path_cost(const MyPoint& start, const std::vector<MyPoint>& path)
+{
+	int cost = 0;
+	MyPoint prev = start;
+	for (const MyPoint& pos : path)
+	{
+		cost += ((pos - prev).manhattanLength() == 2) ? kObliqueValue : kStepValue;
+		prev = pos;
+	}
+	return cost;
+}
+
+void my_bench_header(const std::string& title, const std::string& columns)
+{
+	std::cout << std::endl << title << std::endl << columns << std::endl;
+}
+
+void my_bench_row(const std::string& row)
+{
+	std::cout << row << std::endl;
+}
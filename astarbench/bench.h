@@ -0,0 +1,102 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#pragma once
+#ifndef BENCH_H
+#define BENCH_H
+#pragma execution_character_set("utf-8")
+#include "mymap.h"
+#include "mycontext.h"
+#include <random>
+
+// wall-clock stopwatch, starts when it is created
+class MyBenchTimer
+{
+public:
+	explicit MyBenchTimer()
+		: start_(std::chrono::steady_clock::now())
+	{}
+
+	void restart() { start_ = std::chrono::steady_clock::now(); }
+
+	MY_REQUIRED_RESULT double elapsed_ms() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point start_;
+};
+
+// run fn repeat times and get the fastest run in milliseconds
+// the fastest run is the one least disturbed by the rest of the machine
+template <typename Fn>
+MY_REQUIRED_RESULT double my_bench_best(const int repeat, Fn&& fn)
+{
+	double best = (std::numeric_limits<double>::max)();
+	for (int i = 0; i < repeat; ++i)
+	{
+		MyBenchTimer timer;
+		fn();
+		best = (std::min)(best, timer.elapsed_ms());
+	}
+	return best;
+}
+
+// keep the value alive so the optimizer cannot drop the work that produced it
+void __vectorcall my_bench_keep(const uint64_t value);
+
+// open field with single-cell obstacles scattered at the density (0 to 1), reproducible from the seed
+MY_REQUIRED_RESULT MyMapPtr __vectorcall my_bench_open_map(const int w, const int h, const double density, const unsigned seed);
+
+// perfect maze with one-cell corridors on the odd rows and columns, every road cell reaches every other
+MY_REQUIRED_RESULT MyMapPtr __vectorcall my_bench_maze_map(const int w, const int h, const unsigned seed);
+
+// pairs of road cells at least min_distance apart on the longer axis, reproducible from the seed
+MY_REQUIRED_RESULT std::vector<std::pair<MyPoint, MyPoint>> __vectorcall my_bench_queries(const MyMap& map, const int count, const int min_distance, const unsigned seed);
+
+// number of nodes the last search of the context closed
+MY_REQUIRED_RESULT size_t __vectorcall my_bench_expanded(const MySearchContext& context);
+
+// cost of the path from the start with the step and oblique costs of MyAStar, the start is not in the path
+MY_REQUIRED_RESULT int __vectorcall my_bench_path_cost(const MyPoint& start, const std::vector<MyPoint>& path);
+
+// print the title of a case and the names of its columns
+void __vectorcall my_bench_header(const std::string& title, const std::string& columns);
+
+// print one row of results
+void __vectorcall my_bench_row(const std::string& row);
+
+// one benchmark case, run from the command line by name
+struct MyBenchCase
+{
+	const char* name;
+	const char* summary;
+	void (*run)();
+};
+
+// the cases
+void my_bench_map();
+void my_bench_policy();
+void my_bench_heap();
+void my_bench_jps();
+void my_bench_dstar();
+void my_bench_registry();
+void my_bench_bidir();
+void my_bench_heuristic();
+
+#endif
@@ -0,0 +1,117 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include "myastar.h"
+
+// bidirectional A* against the single-direction search on long queries across the map
+namespace
+{
+	constexpr int kQueries = 20;
+
+	// an open field with the goal inside a walled box whose only door faces away from the starts,
+	// so a search from the start floods everything in front of the box before it walks around it
+	MyMapPtr __vectorcall trap_map(std::vector<std::pair<MyPoint, MyPoint>>* queries)
+	{
+		constexpr int kSize = 1024;
+		constexpr int kWall = 4;
+		const MyMapPtr field = my_bench_open_map(kSize, kSize, 0.05, 1);
+		MyMapEditor editor(*field);
+		const MyRect box{ 512, 256, 384, 512 };
+		editor.fill(MyRect{ box.x, box.y, box.w, kWall }, TYPE_COLLISION);
+		editor.fill(MyRect{ box.x, box.y + box.h - kWall, box.w, kWall }, TYPE_COLLISION);
+		editor.fill(MyRect{ box.x, box.y, kWall, box.h }, TYPE_COLLISION);
+		editor.fill(MyRect{ box.x + box.w - kWall, box.y, kWall, box.h / 2 - 8 }, TYPE_COLLISION);
+		editor.fill(MyRect{ box.x + box.w - kWall, box.y + box.h / 2 + 8, kWall, box.h / 2 - 8 }, TYPE_COLLISION);
+		const MyPoint goal{ box.x + box.w / 2, box.y + box.h / 2 };
+		std::ignore = editor.set(goal.x(), goal.y(), TYPE_ROAD);
+		const MyMapPtr map = editor.publish(field->version + 1);
+
+		std::mt19937 rng(10);
+		while (static_cast<int>(queries->size()) < kQueries)
+		{
+			const MyPoint start{ static_cast<int>(rng() % 128), static_cast<int>(rng() % kSize) };
+			if (map->is_road(start.x(), start.y()))
+				queries->emplace_back(start, goal);
+		}
+		return map;
+	}
+
+	void __vectorcall run_map(const char* name, const MyMapPtr& map, std::vector<std::pair<MyPoint, MyPoint>> queries = {})
+	{
+		const MyMap& grid = *map;
+		if (queries.empty())
+			queries = my_bench_queries(grid, kQueries, grid.width * 3 / 4, 9);
+
+		MySearchContext forward;
+		MySearchContext backward;
+		std::vector<MyPoint> path;
+
+		size_t single_expanded = 0;
+		size_t both_expanded = 0;
+		int64_t single_cost = 0;
+		int64_t both_cost = 0;
+		for (const auto& [start, end] : queries)
+		{
+			const MyParams param(grid.width, grid.height, true, start, end, nullptr);
+			path.clear();
+			if (my_astar_find(&forward, grid, param, &path))
+				single_cost += my_bench_path_cost(start, path);
+			single_expanded += my_bench_expanded(forward);
+
+			path.clear();
+			if (my_astar_find_bidirectional(&forward, &backward, grid, param, &path))
+				both_cost += my_bench_path_cost(start, path);
+			both_expanded += my_bench_expanded(forward) + my_bench_expanded(backward);
+		}
+
+		const double single_ms = my_bench_best(2, [&]()
+			{
+				for (const auto& [start, end] : queries)
+				{
+					path.clear();
+					my_bench_keep(my_astar_find(&forward, grid, MyParams(grid.width, grid.height, true, start, end, nullptr), &path));
+				}
+			});
+
+		const double both_ms = my_bench_best(2, [&]()
+			{
+				for (const auto& [start, end] : queries)
+				{
+					path.clear();
+					my_bench_keep(my_astar_find_bidirectional(&forward, &backward, grid, MyParams(grid.width, grid.height, true, start, end, nullptr), &path));
+				}
+			});
+
+		my_bench_row(std::format("{:<10} {:>12} {:>12} {:>11.1f} {:>11.1f} {:>8.2f}x {:>6}",
+			name, single_expanded, both_expanded, single_ms, both_ms, single_ms / both_ms,
+			(single_cost == both_cost) ? "yes" : "NO"));
+	}
+}
+
+void my_bench_bidir()
+{
+	my_bench_header("bidir: single-direction MyAStar (before) against bidirectional A* (after), 8-dir, 20 long queries per map",
+		"map         expand one  expand both      one ms     both ms     gain  same cost");
+	run_map("open 10%", my_bench_open_map(1024, 1024, 0.1, 1));
+	run_map("open 30%", my_bench_open_map(1024, 1024, 0.3, 1));
+	run_map("maze", my_bench_maze_map(1023, 1023, 1));
+
+	std::vector<std::pair<MyPoint, MyPoint>> queries;
+	const MyMapPtr trap = trap_map(&queries);
+	run_map("trap", trap, queries);
+}
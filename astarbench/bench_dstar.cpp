@@ -0,0 +1,133 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include "myastar.h"
+#include "mydstar.h"
+
+// D* Lite replanning against a full MyAStar search after every local edit
+// an agent walks towards a fixed goal, and every round a barricade is dropped on its path a few cells ahead
+// or the last one is taken away again, then both planners answer the query from the agent's new cell
+namespace
+{
+	constexpr int kRounds = 200;
+	constexpr int kStride = 3;                 // cells the agent walks between two edits
+	constexpr int kAhead = 12;                 // how far ahead of the agent the barricade is dropped
+
+	void __vectorcall run_map(const char* name, const MyMapPtr& first)
+	{
+		const MyMap& grid = *first;
+		const auto queries = my_bench_queries(grid, 1, grid.width * 3 / 4, 7);
+		MyPoint agent = queries.front().first;
+		const MyPoint goal = queries.front().second;
+
+		MySearchContext context;
+		MyDStarLite planner(goal, true);
+		std::vector<MyPoint> astar_path;
+		std::vector<MyPoint> dstar_path;
+
+		MyBenchTimer timer;
+		std::ignore = planner.replan(first, agent, &dstar_path);
+		const double initial_ms = timer.elapsed_ms();
+		std::ignore = my_astar_find(&context, grid, MyParams(grid.width, grid.height, true, agent, goal, nullptr), &astar_path);
+
+		// the agent keeps walking the last path found while a barricade cuts it off
+		std::vector<MyPoint> route = astar_path;
+		size_t step = 0;
+
+		MyMapPtr map = first;
+		uint64_t version = first->version;
+		std::vector<MyPoint> barricade;
+		double astar_ms = 0.0;
+		double dstar_ms = 0.0;
+		int rounds = 0;
+		int mismatches = 0;
+		for (; (rounds < kRounds) && (route.size() > step + kAhead + kStride); ++rounds)
+		{
+			step += kStride;
+			agent = route[step - 1];
+
+			// odd rounds open the last barricade again, even rounds drop a 3x3 one on the path
+			MyMapEditor editor(*map);
+			std::vector<MyPoint> changed;
+			if (!barricade.empty())
+			{
+				for (const MyPoint& pos : barricade)
+				{
+					if (editor.set(pos.x(), pos.y(), TYPE_ROAD))
+						changed.push_back(pos);
+				}
+				barricade.clear();
+			}
+			else
+			{
+				const MyPoint center = route[step - 1 + kAhead];
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						const MyPoint pos{ center.x() + dx, center.y() + dy };
+						if (!grid.contains(pos.x(), pos.y()) || (pos == agent) || (pos == goal))
+							continue;
+
+						if (editor.set(pos.x(), pos.y(), TYPE_COLLISION))
+						{
+							changed.push_back(pos);
+							barricade.push_back(pos);
+						}
+					}
+				}
+			}
+			map = editor.publish(++version);
+			for (const MyPoint& pos : changed)
+				planner.changed(pos, version);
+
+			const MyParams param(grid.width, grid.height, true, agent, goal, nullptr);
+			astar_path.clear();
+			timer.restart();
+			const bool astar_found = my_astar_find(&context, *map, param, &astar_path);
+			astar_ms += timer.elapsed_ms();
+
+			dstar_path.clear();
+			timer.restart();
+			const bool dstar_found = planner.replan(map, agent, &dstar_path);
+			dstar_ms += timer.elapsed_ms();
+
+			if (astar_found)
+			{
+				route = astar_path;
+				step = 0;
+			}
+
+			if ((astar_found != dstar_found) || (my_bench_path_cost(agent, astar_path) != my_bench_path_cost(agent, dstar_path)))
+				++mismatches;
+		}
+
+		my_bench_row(std::format("{:<10} {:>7} {:>11.2f} {:>11.3f} {:>11.3f} {:>8.2f}x {:>10}",
+			name, rounds, initial_ms,
+			astar_ms / rounds, dstar_ms / rounds, astar_ms / dstar_ms, mismatches));
+	}
+}
+
+void my_bench_dstar()
+{
+	my_bench_header("dstar: full MyAStar re-search (before) against D* Lite replanning (after), 8-dir, 3x3 barricades on the path",
+		"map         rounds  d* init ms    a* ms/rp    d* ms/rp     gain  cost diff");
+	run_map("open 10%", my_bench_open_map(512, 512, 0.1, 1));
+	run_map("open 30%", my_bench_open_map(512, 512, 0.3, 1));
+	run_map("maze", my_bench_maze_map(511, 511, 1));
+}
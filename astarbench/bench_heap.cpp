@@ -0,0 +1,260 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include "myastar.h"
+
+// the open list MyAStar used before the indexed heap against MyIndexedHeap, both driven by the same search
+// the search is a plain 8-dir A* with the corner rule of MyAStar, so only the open list differs
+namespace
+{
+	constexpr int kStepValue = 10;
+	constexpr int kObliqueValue = 14;
+
+	// both lists order by f only, like the former one, so they run the same search up to the order of equal f values
+	struct MyFLess
+	{
+		MY_REQUIRED_RESULT __forceinline bool __vectorcall operator()(const Node* a, const Node* b) const { return a->f() < b->f(); }
+	};
+
+	// the former open list: std heap operations, and a linear scan for the node whose g improved before percolating it up
+	class MyLinearOpenList
+	{
+	public:
+		MY_REQUIRED_RESULT bool empty() const { return items_.empty(); }
+
+		void clear() { items_.clear(); }
+
+		void __vectorcall push(Node* node)
+		{
+			items_.push_back(node);
+			std::ranges::push_heap(items_, greater);
+		}
+
+		Node* pop()
+		{
+			std::ranges::pop_heap(items_, greater);
+			Node* node = items_.back();
+			items_.pop_back();
+			return node;
+		}
+
+		void __vectorcall decrease(Node* node)
+		{
+			int hole = 0;
+			const int size = static_cast<int>(items_.size());
+			while ((hole < size) && !(items_[hole]->pos == node->pos))
+				++hole;
+
+			while (hole > 0)
+			{
+				const int parent = (hole - 1) / 2;
+				if (!(items_[hole]->f() < items_[parent]->f()))
+					break;
+
+				std::ranges::swap(items_[hole], items_[parent]);
+				hole = parent;
+			}
+		}
+
+	private:
+		static bool greater(const Node* a, const Node* b) { return a->f() > b->f(); }
+
+		std::vector<Node*> items_;
+	};
+
+	class MyIndexedOpenList
+	{
+	public:
+		MY_REQUIRED_RESULT bool empty() const { return heap_.empty(); }
+
+		void clear() { heap_.clear(); }
+
+		void __vectorcall push(Node* node) { heap_.push(node); }
+
+		Node* pop() { return heap_.pop(); }
+
+		void __vectorcall decrease(Node* node) { heap_.decrease(node); }
+
+	private:
+		MyIndexedHeap<Node, MyFLess> heap_;
+	};
+
+	struct MySearchStats
+	{
+		size_t expanded = 0;
+		size_t decreased = 0;
+		int cost = 0;
+	};
+
+	// one node per cell, only the touched ones are reset between searches
+	struct MyNodeTable
+	{
+		std::vector<Node> nodes;
+		std::vector<int> touched;
+
+		explicit MyNodeTable(const size_t count)
+			: nodes(count)
+		{}
+
+		Node* __vectorcall touch(const int index)
+		{
+			touched.push_back(index);
+			return &nodes[index];
+		}
+
+		void reset()
+		{
+			for (const int index : touched)
+				nodes[index] = Node{};
+			touched.clear();
+		}
+	};
+
+	template <typename OpenList, typename Heuristic>
+	MySearchStats __vectorcall search(const MyMap& grid, const MyPoint& start, const MyPoint& end, const Heuristic& heuristic, OpenList& open, MyNodeTable& table)
+	{
+		MySearchStats stats;
+		const int w = grid.width;
+		auto pass = [&grid](const int x, const int y) { return grid.contains(x, y) && grid.is_road(x, y); };
+		auto estimate = [&heuristic, &end](const int x, const int y)
+		{
+			return heuristic(std::abs(x - end.x()), std::abs(y - end.y()), kStepValue, kObliqueValue);
+		};
+
+		table.reset();
+		open.clear();
+		Node* first = table.touch(start.y() * w + start.x());
+		first->pos = start;
+		first->h = estimate(start.x(), start.y());
+		first->state = IN_OPENLIST;
+		open.push(first);
+
+		while (!open.empty())
+		{
+			Node* current = open.pop();
+			current->state = IN_CLOSEDLIST;
+			++stats.expanded;
+			if (current->pos == end)
+			{
+				stats.cost = current->g;
+				return stats;
+			}
+
+			const int x = current->pos.x();
+			const int y = current->pos.y();
+			const bool up = pass(x, y - 1);
+			const bool left = pass(x - 1, y);
+			const bool right = pass(x + 1, y);
+			const bool down = pass(x, y + 1);
+			const struct { bool ok; int dx; int dy; } moves[8] = {
+				{ up && left && pass(x - 1, y - 1), -1, -1 }, { up, 0, -1 }, { up && right && pass(x + 1, y - 1), 1, -1 },
+				{ left, -1, 0 }, { right, 1, 0 },
+				{ down && left && pass(x - 1, y + 1), -1, 1 }, { down, 0, 1 }, { down && right && pass(x + 1, y + 1), 1, 1 },
+			};
+
+			for (const auto& move : moves)
+			{
+				if (!move.ok)
+					continue;
+
+				const int nx = x + move.dx;
+				const int ny = y + move.dy;
+				Node* next = &table.nodes[ny * w + nx];
+				if (IN_CLOSEDLIST == next->state)
+					continue;
+
+				const int g = current->g + ((move.dx && move.dy) ? kObliqueValue : kStepValue);
+				if (NOTEXIST == next->state)
+				{
+					std::ignore = table.touch(ny * w + nx);
+					next->pos = MyPoint{ nx, ny };
+					next->g = g;
+					next->h = estimate(nx, ny);
+					next->parent = current;
+					next->state = IN_OPENLIST;
+					open.push(next);
+				}
+				else if (g < next->g)
+				{
+					next->g = g;
+					next->parent = current;
+					open.decrease(next);
+					++stats.decreased;
+				}
+			}
+		}
+		return stats;
+	}
+
+	template <typename Heuristic>
+	void __vectorcall run_map(const char* name, const char* heuristic_name, const MyMapPtr& map, const Heuristic& heuristic)
+	{
+		constexpr int kQueries = 50;
+		const MyMap& grid = *map;
+		const auto queries = my_bench_queries(grid, kQueries, grid.width / 4, 4);
+		MyNodeTable table(static_cast<size_t>(grid.width) * grid.height);
+
+		MySearchStats linear_stats;
+		MyLinearOpenList linear;
+		const double linear_ms = my_bench_best(3, [&]()
+			{
+				linear_stats = {};
+				for (const auto& [start, end] : queries)
+				{
+					const MySearchStats stats = search(grid, start, end, heuristic, linear, table);
+					linear_stats.expanded += stats.expanded;
+					linear_stats.decreased += stats.decreased;
+					linear_stats.cost += stats.cost;
+				}
+			});
+
+		MySearchStats indexed_stats;
+		MyIndexedOpenList indexed;
+		const double indexed_ms = my_bench_best(3, [&]()
+			{
+				indexed_stats = {};
+				for (const auto& [start, end] : queries)
+				{
+					const MySearchStats stats = search(grid, start, end, heuristic, indexed, table);
+					indexed_stats.expanded += stats.expanded;
+					indexed_stats.decreased += stats.decreased;
+					indexed_stats.cost += stats.cost;
+				}
+			});
+
+		my_bench_row(std::format("{:<10} {:<9} {:>10} {:>10} {:>10} {:>10} {:>11.1f} {:>11.1f} {:>8.2f}x",
+			name, heuristic_name,
+			linear_stats.expanded, linear_stats.decreased, indexed_stats.expanded, indexed_stats.decreased,
+			linear_ms, indexed_ms, linear_ms / indexed_ms));
+	}
+}
+
+void my_bench_heap()
+{
+	my_bench_header("heap: linear-scan decrease-key (before) against the indexed heap (after), 8-dir, 50 queries",
+		"map        h           expand l decrease l   expand i decrease i   linear ms  indexed ms  speedup");
+	const MyMapPtr empty = my_bench_open_map(512, 512, 0.0, 1);
+	const MyMapPtr open = my_bench_open_map(512, 512, 0.1, 1);
+	const MyMapPtr dense = my_bench_open_map(512, 512, 0.3, 1);
+	run_map("open 0%", "manhattan", empty, MyManhattan{});
+	run_map("open 10%", "manhattan", open, MyManhattan{});
+	run_map("open 30%", "manhattan", dense, MyManhattan{});
+	run_map("open 0%", "octile", empty, MyOctile{});
+	run_map("open 10%", "octile", open, MyOctile{});
+	run_map("open 30%", "octile", dense, MyOctile{});
+}
@@ -0,0 +1,109 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include "myastar.h"
+
+// the heuristic policies of MyAStar on the same 8-dir queries: expansions, path cost and time
+// manhattan is the estimate MyAStar used before the policies, it overestimates the diagonal moves
+namespace
+{
+	constexpr int kQueries = 100;
+
+	struct MyHeuristicStats
+	{
+		size_t expanded = 0;
+		int64_t cost = 0;
+		int suboptimal = 0;
+		double worst = 0.0;                 // largest excess over the shortest path, percent
+		double ms = 0.0;
+	};
+
+	template <typename Heuristic>
+	MyHeuristicStats __vectorcall measure(const MyMap& grid, const std::vector<std::pair<MyPoint, MyPoint>>& queries, const std::vector<int>& shortest, const Heuristic& heuristic)
+	{
+		MySearchContext context;
+		MyAStar<MyGridPass, true, Heuristic> astar(&context, MyGridPass{ &grid }, heuristic);
+		std::vector<MyPoint> path;
+
+		MyHeuristicStats stats;
+		for (size_t i = 0; i < queries.size(); ++i)
+		{
+			const auto& [start, end] = queries[i];
+			path.clear();
+			if (!astar.find(MyParams(grid.width, grid.height, true, start, end, nullptr), &path))
+				continue;
+
+			const int cost = my_bench_path_cost(start, path);
+			stats.expanded += my_bench_expanded(context);
+			stats.cost += cost;
+			if (cost > shortest[i])
+			{
+				++stats.suboptimal;
+				stats.worst = (std::max)(stats.worst, (cost - shortest[i]) * 100.0 / shortest[i]);
+			}
+		}
+
+		stats.ms = my_bench_best(3, [&]()
+			{
+				for (const auto& [start, end] : queries)
+				{
+					path.clear();
+					my_bench_keep(astar.find(MyParams(grid.width, grid.height, true, start, end, nullptr), &path));
+				}
+			});
+		return stats;
+	}
+
+	void __vectorcall print(const char* name, const char* heuristic, const MyHeuristicStats& stats)
+	{
+		my_bench_row(std::format("{:<10} {:<14} {:>11} {:>11} {:>10} {:>9.1f}% {:>10.1f}",
+			name, heuristic, stats.expanded, stats.cost, stats.suboptimal, stats.worst, stats.ms));
+	}
+
+	void __vectorcall run_map(const char* name, const MyMapPtr& map)
+	{
+		const MyMap& grid = *map;
+		const auto queries = my_bench_queries(grid, kQueries, grid.width / 4, 11);
+
+		// octile never overestimates, so its paths are the shortest ones
+		std::vector<int> shortest;
+		MySearchContext context;
+		std::vector<MyPoint> path;
+		for (const auto& [start, end] : queries)
+		{
+			path.clear();
+			const bool found = my_astar_find(&context, grid, MyParams(grid.width, grid.height, true, start, end, nullptr), &path);
+			shortest.push_back(found ? my_bench_path_cost(start, path) : 0);
+		}
+
+		print(name, "manhattan", measure(grid, queries, shortest, MyManhattan{}));
+		print(name, "octile", measure(grid, queries, shortest, MyOctile{}));
+		print(name, "chebyshev", measure(grid, queries, shortest, MyChebyshev{}));
+		print(name, "octile x1.5", measure(grid, queries, shortest, MyWeighted<MyOctile>{ MyOctile{}, 150 }));
+	}
+}
+
+void my_bench_heuristic()
+{
+	my_bench_header("heuristic: the former manhattan estimate against the heuristic policies, 8-dir, 100 queries",
+		"map        h                 expanded   path cost  too long     worst          ms");
+	run_map("open 0%", my_bench_open_map(512, 512, 0.0, 1));
+	run_map("open 10%", my_bench_open_map(512, 512, 0.1, 1));
+	run_map("open 30%", my_bench_open_map(512, 512, 0.3, 1));
+	run_map("maze", my_bench_maze_map(511, 511, 1));
+}
@@ -0,0 +1,98 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include "myjps.h"
+
+// Jump Point Search, with and without the JPS+ table, against MyAStar on the same 8-dir queries
+namespace
+{
+	template <typename Find>
+	void __vectorcall count(const MyMap& grid, const std::vector<std::pair<MyPoint, MyPoint>>& queries, MySearchContext& context, Find&& find, size_t* expanded, int64_t* cost)
+	{
+		std::vector<MyPoint> path;
+		*expanded = 0;
+		*cost = 0;
+		for (const auto& [start, end] : queries)
+		{
+			path.clear();
+			if (find(MyParams(grid.width, grid.height, true, start, end, nullptr), &path))
+				*cost += my_bench_path_cost(start, path);
+			*expanded += my_bench_expanded(context);
+		}
+	}
+
+	template <typename Find>
+	double __vectorcall time(const MyMap& grid, const std::vector<std::pair<MyPoint, MyPoint>>& queries, Find&& find)
+	{
+		std::vector<MyPoint> path;
+		return my_bench_best(3, [&]()
+			{
+				for (const auto& [start, end] : queries)
+				{
+					path.clear();
+					my_bench_keep(find(MyParams(grid.width, grid.height, true, start, end, nullptr), &path));
+				}
+			});
+	}
+
+	void __vectorcall run_map(const char* name, const MyMapPtr& map)
+	{
+		constexpr int kQueries = 100;
+		const auto queries = my_bench_queries(*map, kQueries, map->width / 4, 6);
+
+		// the same cells with the JPS+ table attached
+		MyMapEditor editor(*map);
+		editor.attach(MyJumpTable::build(*map));
+		const MyMapPtr tabled = editor.publish(map->version + 1);
+
+		MySearchContext context;
+		auto astar = [&](const MyParams& param, std::vector<MyPoint>* path) { return my_astar_find(&context, *map, param, path); };
+		auto jps = [&](const MyParams& param, std::vector<MyPoint>* path) { return my_jps_find(&context, *map, param, path); };
+		auto jps_plus = [&](const MyParams& param, std::vector<MyPoint>* path) { return my_jps_find(&context, *tabled, param, path); };
+
+		size_t astar_expanded = 0;
+		size_t jps_expanded = 0;
+		size_t plus_expanded = 0;
+		int64_t astar_cost = 0;
+		int64_t jps_cost = 0;
+		int64_t plus_cost = 0;
+		count(*map, queries, context, astar, &astar_expanded, &astar_cost);
+		count(*map, queries, context, jps, &jps_expanded, &jps_cost);
+		count(*map, queries, context, jps_plus, &plus_expanded, &plus_cost);
+
+		const double astar_ms = time(*map, queries, astar);
+		const double jps_ms = time(*map, queries, jps);
+		const double plus_ms = time(*map, queries, jps_plus);
+
+		my_bench_row(std::format("{:<10} {:>11} {:>11} {:>10.1f} {:>10.1f} {:>10.1f} {:>8.2f}x {:>8.2f}x {:>6}",
+			name, astar_expanded, jps_expanded,
+			astar_ms, jps_ms, plus_ms,
+			astar_ms / jps_ms, astar_ms / plus_ms,
+			((astar_cost == jps_cost) && (astar_cost == plus_cost)) ? "yes" : "NO"));
+	}
+}
+
+void my_bench_jps()
+{
+	my_bench_header("jps: MyAStar (before) against JPS and JPS+ (after), 8-dir, 100 queries",
+		"map        expand a*  expand jps    a* ms    jps ms   jps+ ms  jps gain  jps+ gain  same cost");
+	run_map("open 0%", my_bench_open_map(512, 512, 0.0, 1));
+	run_map("open 10%", my_bench_open_map(512, 512, 0.1, 1));
+	run_map("open 30%", my_bench_open_map(512, 512, 0.3, 1));
+	run_map("maze", my_bench_maze_map(511, 511, 1));
+}
@@ -0,0 +1,129 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+
+// the storage MyMap used before the bit grid, one hash entry per cell
+// the allocator adds up the bytes the container asks for, the allocator's own overhead per block is not included
+namespace
+{
+	template <typename T>
+	struct MyCountingAllocator
+	{
+		using value_type = T;
+
+		size_t* bytes = nullptr;
+
+		explicit MyCountingAllocator(size_t* counter)
+			: bytes(counter)
+		{}
+
+		template <typename U>
+		MyCountingAllocator(const MyCountingAllocator<U>& other)
+			: bytes(other.bytes)
+		{}
+
+		T* allocate(const size_t n)
+		{
+			*bytes += n * sizeof(T);
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+
+		void deallocate(T* p, const size_t n)
+		{
+			*bytes -= n * sizeof(T);
+			::operator delete(p);
+		}
+
+		template <typename U>
+		bool operator== (const MyCountingAllocator<U>& other) const { return bytes == other.bytes; }
+	};
+
+	using MyHashCells = std::unordered_map<MyPoint, OBJECTTYPE, KeyHash, KeyEqual, MyCountingAllocator<std::pair<const MyPoint, OBJECTTYPE>>>;
+
+	// bytes held by the grid of the map, the chunk words and the chunk table
+	size_t __vectorcall grid_bytes(const MyMap& map)
+	{
+		return sizeof(MyMap) + map.chunks.size() * (sizeof(MyMap::Chunk) + map.chunk_words() * sizeof(uint64_t));
+	}
+
+	void __vectorcall run_size(const int size)
+	{
+		constexpr int kProbes = 1 << 20;
+		constexpr double kDensity = 0.2;
+
+		const MyMapPtr map = my_bench_open_map(size, size, kDensity, 1);
+
+		// filled column by column like the former _createNewMap, then the collisions are written over it
+		size_t hash_bytes = 0;
+		MyHashCells cells(0, KeyHash{}, KeyEqual{}, MyHashCells::allocator_type(&hash_bytes));
+		for (int x = 0; x < size; ++x)
+		{
+			for (int y = 0; y < size; ++y)
+				cells.insert({ MyPoint{ x, y }, TYPE_ROAD });
+		}
+
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				if (!map->is_road(x, y))
+					cells.at(MyPoint{ x, y }) = TYPE_COLLISION;
+			}
+		}
+
+		std::mt19937 rng(2);
+		std::uniform_int_distribution<int> dist(0, size - 1);
+		std::vector<MyPoint> probes;
+		probes.reserve(kProbes);
+		for (int i = 0; i < kProbes; ++i)
+			probes.emplace_back(dist(rng), dist(rng));
+
+		// the former search callback probed twice, contains then at
+		const double hash_ms = my_bench_best(5, [&]()
+			{
+				uint64_t roads = 0;
+				for (const MyPoint& p : probes)
+					roads += (cells.contains(p) && (cells.at(p) == TYPE_ROAD)) ? 1 : 0;
+				my_bench_keep(roads);
+			});
+
+		const MyMap& grid = *map;
+		const double grid_ms = my_bench_best(5, [&]()
+			{
+				uint64_t roads = 0;
+				for (const MyPoint& p : probes)
+					roads += (grid.contains(p.x(), p.y()) && grid.is_road(p.x(), p.y())) ? 1 : 0;
+				my_bench_keep(roads);
+			});
+
+		const double count = static_cast<double>(size) * size;
+		my_bench_row(std::format("{:>5}x{:<5} {:>12.1f} {:>12.2f} {:>9.2f} {:>9.3f} {:>10.1f} {:>10.1f}",
+			size, size,
+			hash_bytes / 1048576.0, grid_bytes(grid) / 1048576.0,
+			hash_bytes / count, grid_bytes(grid) / count,
+			hash_ms * 1e6 / kProbes, grid_ms * 1e6 / kProbes));
+	}
+}
+
+void my_bench_map()
+{
+	my_bench_header("map: unordered_map cells (before) against the bit grid (after), 20% collisions, 1M random probes",
+		"size         hash MiB     grid MiB   B/cell h  B/cell g  probe h ns  probe g ns");
+	for (const int size : { 256, 1024, 4096 })
+		run_size(size);
+}
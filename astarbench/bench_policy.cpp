@@ -0,0 +1,80 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include "myastar.h"
+
+// the same searches through the std::function callback path and through the inlined grid policy
+namespace
+{
+	void __vectorcall run_map(const char* name, const MyMapPtr& map, const bool corner)
+	{
+		constexpr int kQueries = 200;
+		const MyMap& grid = *map;
+		const auto queries = my_bench_queries(grid, kQueries, grid.width / 4, 3);
+		const Callback callback = [&grid](const MyPoint& pos) { return grid.is_road(pos.x(), pos.y()); };
+
+		MySearchContext context;
+		std::vector<MyPoint> path;
+
+		// the two paths run the same search, so the nodes are counted once outside the timed runs
+		size_t expanded = 0;
+		for (const auto& [start, end] : queries)
+		{
+			path.clear();
+			std::ignore = my_astar_find(&context, grid, MyParams(grid.width, grid.height, corner, start, end, nullptr), &path);
+			expanded += my_bench_expanded(context);
+		}
+
+		const double callback_ms = my_bench_best(3, [&]()
+			{
+				for (const auto& [start, end] : queries)
+				{
+					path.clear();
+					my_bench_keep(my_astar_find(&context, MyParams(grid.width, grid.height, corner, start, end, callback), &path));
+				}
+			});
+
+		const double grid_ms = my_bench_best(3, [&]()
+			{
+				for (const auto& [start, end] : queries)
+				{
+					path.clear();
+					my_bench_keep(my_astar_find(&context, grid, MyParams(grid.width, grid.height, corner, start, end, nullptr), &path));
+				}
+			});
+
+		my_bench_row(std::format("{:<10} {:<6} {:>12} {:>12.1f} {:>12.1f} {:>14.2f} {:>14.2f} {:>8.2f}x",
+			name, corner ? "8-dir" : "4-dir", expanded,
+			callback_ms, grid_ms,
+			expanded / callback_ms / 1000.0, expanded / grid_ms / 1000.0,
+			callback_ms / grid_ms));
+	}
+}
+
+void my_bench_policy()
+{
+	my_bench_header("policy: std::function callback (before) against the inlined grid policy (after), 200 queries",
+		"map        dir        expanded  callback ms      grid ms  callback M/s      grid M/s  speedup");
+	const MyMapPtr open = my_bench_open_map(512, 512, 0.2, 1);
+	const MyMapPtr maze = my_bench_maze_map(511, 511, 1);
+	for (const bool corner : { true, false })
+	{
+		run_map("open 20%", open, corner);
+		run_map("maze", maze, corner);
+	}
+}
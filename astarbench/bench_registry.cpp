@@ -0,0 +1,137 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include "castar.h"
+#include <thread>
+#include <numeric>
+
+// threads mixing collision edits and searches through CAStar, on one shared map or on a map per thread
+// one operation in ten is an edit, the rest are queries between road cells of the original map
+namespace
+{
+	constexpr int kMaps = 8;
+	constexpr int kSize = 256;
+	constexpr int kQueries = 256;
+	constexpr int kRunMs = 1000;
+
+	struct MyStressResult
+	{
+		uint64_t queries = 0;
+		uint64_t edits = 0;
+		std::vector<double> edit_ms;
+	};
+
+	std::wstring __vectorcall map_name(const int index)
+	{
+		return std::format(L"bench_registry_{}", index);
+	}
+
+	void __vectorcall run_threads(const std::vector<std::pair<MyPoint, MyPoint>>& queries, const int threads, const bool shared)
+	{
+		CAStar& engine = CAStar::get_instance();
+		std::atomic<bool> stop = false;
+		std::vector<MyStressResult> results(threads);
+		std::vector<std::thread> workers;
+		for (int t = 0; t < threads; ++t)
+		{
+			workers.emplace_back([&, t]()
+				{
+					const std::wstring mapid = map_name(shared ? 0 : (t % kMaps));
+					MyStressResult& result = results[t];
+					std::mt19937 rng(100 + t);
+					std::vector<MyPoint> path;
+					while (!stop.load(std::memory_order_relaxed))
+					{
+						if ((rng() % 10) == 0)
+						{
+							const int x = static_cast<int>(rng() % kSize);
+							const int y = static_cast<int>(rng() % kSize);
+							MyBenchTimer timer;
+							if (result.edits & 1)
+								std::ignore = engine._removeCollision(mapid, x, y);
+							else
+								std::ignore = engine._addCollision(mapid, x, y);
+							result.edit_ms.push_back(timer.elapsed_ms());
+							++result.edits;
+						}
+						else
+						{
+							const auto& [start, end] = queries[rng() % queries.size()];
+							path.clear();
+							std::ignore = engine._start(mapid, start, end, &path);
+							++result.queries;
+						}
+					}
+				});
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(kRunMs));
+		stop = true;
+		for (std::thread& worker : workers)
+			worker.join();
+
+		MyStressResult total;
+		for (const MyStressResult& result : results)
+		{
+			total.queries += result.queries;
+			total.edits += result.edits;
+			total.edit_ms.insert(total.edit_ms.end(), result.edit_ms.begin(), result.edit_ms.end());
+		}
+		std::ranges::sort(total.edit_ms);
+		const double avg = total.edit_ms.empty() ? 0.0 : std::accumulate(total.edit_ms.begin(), total.edit_ms.end(), 0.0) / total.edit_ms.size();
+		const double p99 = total.edit_ms.empty() ? 0.0 : total.edit_ms[total.edit_ms.size() * 99 / 100];
+		const double max = total.edit_ms.empty() ? 0.0 : total.edit_ms.back();
+
+		my_bench_row(std::format("{:<9} {:>7} {:>11.0f} {:>11.0f} {:>13.3f} {:>13.3f} {:>13.3f}",
+			shared ? "one map" : "own map", threads,
+			total.queries * 1000.0 / kRunMs, total.edits * 1000.0 / kRunMs, avg, p99, max));
+	}
+}
+
+void my_bench_registry()
+{
+	my_bench_header(std::format("registry: edits and searches on many threads through CAStar, {} ms per row, {} hardware threads", kRunMs, std::thread::hardware_concurrency()),
+		"maps       threads   queries/s     edits/s   edit avg ms   edit p99 ms   edit max ms");
+
+	// every map starts as the same 256x256 field with 10% collisions
+	CAStar& engine = CAStar::get_instance();
+	const MyMapPtr field = my_bench_open_map(kSize, kSize, 0.1, 1);
+	for (int i = 0; i < kMaps; ++i)
+	{
+		const std::wstring mapid = map_name(i);
+		std::ignore = engine._createNewMap(mapid, kSize, kSize);
+		for (int y = 0; y < kSize; ++y)
+		{
+			for (int x = 0; x < kSize; ++x)
+			{
+				if (!field->is_road(x, y))
+					std::ignore = engine._addCollision(mapid, x, y);
+			}
+		}
+	}
+
+	const auto queries = my_bench_queries(*field, kQueries, kSize / 4, 8);
+	for (const bool shared : { true, false })
+	{
+		for (const int threads : { 1, 2, 4, 8 })
+			run_threads(queries, threads, shared);
+	}
+
+	for (int i = 0; i < kMaps; ++i)
+		std::ignore = engine._freeMap(map_name(i));
+}
@@ -0,0 +1,61 @@
+﻿/*
+* Copyright (c) 2019-2022 bestkakkoii llc.
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+#include "bench.h"
+#include <iostream>
+
+// astarbench [case...]
+// runs the named cases, or every case without arguments, and prints their tables
+// build it in Release, the numbers of a Debug build say nothing about the engine
+
+static const MyBenchCase kCases[] = {
+	{ "map", "bit grid against the former unordered_map storage: memory and lookup latency", my_bench_map },
+	{ "policy", "std::function callback against the inlined grid policy: expansions per second", my_bench_policy },
+	{ "heap", "linear-scan decrease-key against the indexed heap on open 8-dir maps", my_bench_heap },
+	{ "jps", "MyAStar against JPS and JPS+ on open fields and a maze", my_bench_jps },
+	{ "dstar", "D* Lite replanning against a full A* search after local edits", my_bench_dstar },
+	{ "registry", "edits and searches mixed on many threads through CAStar", my_bench_registry },
+	{ "bidir", "bidirectional A* against the single-direction search on long queries", my_bench_bidir },
+	{ "heuristic", "the former manhattan estimate against the heuristic policies: expansions and path cost", my_bench_heuristic },
+};
+
+int main(int argc, char* argv[])
+{
+	std::vector<const MyBenchCase*> selected;
+	for (int i = 1; i < argc; ++i)
+	{
+		const auto it = std::ranges::find_if(kCases, [name = std::string(argv[i])](const MyBenchCase& c) { return name == c.name; });
+		if (it == std::end(kCases))
+		{
+			std::cerr << "unknown case " << argv[i] << ", the cases are:" << std::endl;
+			for (const MyBenchCase& c : kCases)
+				std::cerr << "  " << c.name << "  " << c.summary << std::endl;
+			return 1;
+		}
+		selected.push_back(&*it);
+	}
+
+	if (selected.empty())
+	{
+		for (const MyBenchCase& c : kCases)
+			selected.push_back(&c);
+	}
+
+	for (const MyBenchCase* c : selected)
+		c->run();
+	return 0;
+}